@@ -0,0 +1,339 @@
+/***********************************************************
+LZSS compressed blob storage on an EEPROM.
+************************************************************/
+#include "compressed_store.h"
+
+/**
+ * CompressedStore(EEPROM &ep)
+ *
+ * Constructor
+ * @param ep eeprom holding the blobs (EEPROM&)
+ * @return none
+ */
+CompressedStore::CompressedStore(EEPROM &ep) : _ep(ep)
+{
+  _errnum = EEPROM_NoError;
+  _original = 0;
+  _stored = 0;
+  _time = 0;
+  _address = 0;
+  _end = 0;
+  _fill = 0;
+  _pos = 0;
+}
+
+/**
+ * uint32_t write(uint32_t address, void *data, uint32_t size, uint32_t max_size)
+ *
+ * Compress and write a blob, one page program per compressed page
+ * @param address start address (uint32_t)
+ * @param data data to write (void *)
+ * @param size number of bytes to write (uint32_t)
+ * @param max_size size of the eeprom area available for the blob (uint32_t)
+ * @return number of bytes stored, header included, 0 on error (uint32_t)
+ */
+uint32_t CompressedStore::write(uint32_t address, void *data, uint32_t size, uint32_t max_size)
+{
+  const uint8_t *in = (const uint8_t *)data;
+  uint8_t group[1 + 8 * 2];
+  uint32_t start = us_ticker_read();
+  uint32_t pos = 0, first, cand, best, distance, len;
+  uint8_t bit, n;
+
+  _errnum = EEPROM_NoError;
+  _original = size;
+  _stored = 0;
+
+  // Check parameters
+  if (data == NULL)
+  {
+    _errnum = EEPROM_ParamError;
+    return (0);
+  }
+
+  if (address + max_size > _ep.getSize())
+  {
+    _errnum = EEPROM_OutOfRange;
+    return (0);
+  }
+
+  _address = address;
+  _end = address + max_size;
+  _fill = 0;
+
+  // Header
+  memcpy(group, &size, 4);
+  group[4] = LZ_Marker;
+  group[5] = LZ_WindowBits;
+  put(group, LZ_HeaderSize);
+
+  while (pos < size && !_errnum)
+  {
+    group[0] = 0;
+    n = 1;
+    for (bit = 0; bit < 8 && pos < size; bit++)
+    {
+      // Longest match in the window, the nearest one on a tie
+      best = 0;
+      distance = 0;
+      first = (pos > (1 << LZ_WindowBits)) ? pos - (1 << LZ_WindowBits) : 0;
+      for (cand = pos; cand-- > first && best < LZ_MaxMatch;)
+      {
+        for (len = 0; len < LZ_MaxMatch && pos + len < size && in[cand + len] == in[pos + len]; len++)
+          ;
+        if (len > best)
+        {
+          best = len;
+          distance = pos - cand;
+        }
+      }
+
+      if (best >= LZ_MinMatch)
+      {
+        group[0] |= 1 << bit;
+        group[n++] = (distance - 1) & 0xFF;
+        group[n++] = ((distance - 1) >> 8) << LZ_LengthBits | (best - LZ_MinMatch);
+        pos += best;
+      }
+      else
+        group[n++] = in[pos++];
+    }
+    put(group, n);
+  }
+  flush();
+
+  _stored = _address - address;
+  _time = us_ticker_read() - start;
+
+  return (_errnum ? 0 : _stored);
+}
+
+/**
+ * uint32_t read(uint32_t address, void *data, uint32_t size)
+ *
+ * Read and decompress a blob, one page sized read at a time
+ * @param address start address (uint32_t)
+ * @param data buffer for the data (void *)
+ * @param size buffer size in bytes (uint32_t)
+ * @return original size of the blob, 0 on error (uint32_t)
+ */
+uint32_t CompressedStore::read(uint32_t address, void *data, uint32_t size)
+{
+  uint8_t *out = (uint8_t *)data;
+  uint8_t header[LZ_HeaderSize];
+  uint32_t start = us_ticker_read();
+  uint32_t pos = 0, distance, len, i;
+  uint8_t flags, bit, b0, b1;
+
+  _errnum = EEPROM_NoError;
+  _original = 0;
+  _stored = 0;
+
+  // Check parameters
+  if (data == NULL)
+  {
+    _errnum = EEPROM_ParamError;
+    return (0);
+  }
+
+  _address = address;
+  _end = _ep.getSize();
+  _fill = 0;
+  _pos = 0;
+
+  for (i = 0; i < LZ_HeaderSize && get(header[i]); i++)
+    ;
+  if (_errnum)
+    return (0);
+
+  memcpy(&_original, header, 4);
+  if (header[4] != LZ_Marker || header[5] != LZ_WindowBits || _original > size)
+  {
+    _errnum = EEPROM_ParamError;
+    return (0);
+  }
+
+  while (pos < _original && get(flags))
+  {
+    for (bit = 0; bit < 8 && pos < _original && !_errnum; bit++)
+    {
+      if (!(flags & (1 << bit)))
+      {
+        get(out[pos++]);
+        continue;
+      }
+
+      if (!get(b0) || !get(b1))
+        break;
+
+      // Matches only reach the data already decompressed
+      distance = (b0 | (b1 >> LZ_LengthBits) << 8) + 1;
+      len = (b1 & ((1 << LZ_LengthBits) - 1)) + LZ_MinMatch;
+      if (distance > pos || len > _original - pos)
+      {
+        _errnum = EEPROM_OutOfRange;
+        break;
+      }
+      for (i = 0; i < len; i++, pos++)
+        out[pos] = out[pos - distance];
+    }
+  }
+
+  _stored = _address + _pos - address;
+  _time = us_ticker_read() - start;
+
+  return (_errnum ? 0 : _original);
+}
+
+/**
+ * uint32_t getOriginalSize(void)
+ *
+ * Get the original size of the last blob written or read
+ * @param none
+ * @return size in bytes (uint32_t)
+ */
+uint32_t CompressedStore::getOriginalSize(void)
+{
+  return (_original);
+}
+
+/**
+ * uint32_t getStoredSize(void)
+ *
+ * Get the stored size, header included, of the last blob written or read
+ * @param none
+ * @return size in bytes (uint32_t)
+ */
+uint32_t CompressedStore::getStoredSize(void)
+{
+  return (_stored);
+}
+
+/**
+ * uint32_t getRatio(void)
+ *
+ * Get the compression ratio of the last blob written or read, original size / stored size
+ * @param none
+ * @return ratio in percent (uint32_t)
+ */
+uint32_t CompressedStore::getRatio(void)
+{
+  if (!_stored)
+    return (0);
+
+  return ((uint64_t)_original * 100 / _stored);
+}
+
+/**
+ * uint32_t getTime(void)
+ *
+ * Get the duration of the last write or read, bus included
+ * @param none
+ * @return duration in us (uint32_t)
+ */
+uint32_t CompressedStore::getTime(void)
+{
+  return (_time);
+}
+
+/**
+ * uint8_t getError(void)
+ *
+ * Get the current error number (EEPROM_NoError if no error)
+ * @param none
+ * @return none
+ */
+uint8_t CompressedStore::getError(void)
+{
+  return (_errnum);
+}
+
+/**
+ * bool put(const uint8_t *data, uint32_t size)
+ *
+ * Add bytes to the compressed stream, the page buffer is written when it reaches a page boundary
+ * @param data bytes to add (const uint8_t *)
+ * @param size number of bytes (uint32_t)
+ * @return true if added, false if the area is full or on error (bool)
+ */
+bool CompressedStore::put(const uint8_t *data, uint32_t size)
+{
+  uint32_t i;
+
+  for (i = 0; i < size && !_errnum; i++)
+  {
+    if (_address + _fill >= _end)
+    {
+      _errnum = EEPROM_OutOfRange;
+      break;
+    }
+
+    _page[_fill++] = data[i];
+    if ((_address + _fill) % _ep.getPageSize() == 0)
+      flush();
+  }
+
+  return (!_errnum);
+}
+
+/**
+ * bool flush(void)
+ *
+ * Write the page buffer
+ * @param none
+ * @return true if written, overwise false (bool)
+ */
+bool CompressedStore::flush(void)
+{
+  if (_fill && !_errnum)
+  {
+    _ep.write(_address, (int8_t *)_page, _fill);
+    if (_ep.getError() != EEPROM_NoError)
+      _errnum = _ep.getError();
+    _address += _fill;
+    _fill = 0;
+  }
+
+  return (!_errnum);
+}
+
+/**
+ * bool get(uint8_t &data)
+ *
+ * Get the next byte of the compressed stream, the page buffer is read up to the next page boundary
+ * @param data next byte (uint8_t&)
+ * @return true if read, overwise false (bool)
+ */
+bool CompressedStore::get(uint8_t &data)
+{
+  uint32_t n;
+
+  if (_errnum)
+    return (false);
+
+  if (_pos == _fill)
+  {
+    _address += _fill;
+    n = _ep.getPageSize() - _address % _ep.getPageSize();
+    if (n > _end - _address)
+      n = _end - _address;
+    if (!n)
+    {
+      _errnum = EEPROM_OutOfRange;
+      return (false);
+    }
+
+    _ep.read(_address, (int8_t *)_page, n);
+    if (_ep.getError() != EEPROM_NoError)
+    {
+      _errnum = _ep.getError();
+      return (false);
+    }
+    _fill = n;
+    _pos = 0;
+  }
+
+  data = _page[_pos++];
+
+  return (true);
+}
@@ -0,0 +1,139 @@
+#ifndef __COMPRESSED_STORE__H_
+#define __COMPRESSED_STORE__H_
+
+/***********************************************************
+LZSS compressed blob storage on an EEPROM.
+
+Blobs are compressed while they are written and decompressed while they
+are read, one page at a time : the only buffer is one page, the
+compressor searches its matches in the source data and the decompressor
+copies its matches from the data already decompressed. Less stored bytes
+means less page programs on write and a shorter transfer on read.
+
+The codec is a plain LZSS : groups of 8 items led by a flag byte (bit
+set for a match, lsb first), a literal is 1 byte, a match is 2 bytes
+holding a 10 bits distance (1 to 1024) and a 6 bits length (3 to 66).
+The compression time grows with the window size (brute force search).
+
+Blob layout (little endian) :
+  - original size (uint32_t)
+  - marker 0x4C (uint8_t)
+  - window bits (uint8_t)
+  - compressed stream
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom.h"
+#include "compressed_store.h"
+
+EEPROM ep(p9,p10,0,EEPROM::T24C256);
+CompressedStore store(ep);
+int16_t table[2048];
+
+int main()
+{
+  store.write(0x1000,table,sizeof(table),0x2000);
+  printf("%u bytes stored, ratio %u%%, %u us\n",store.getStoredSize(),store.getRatio(),store.getTime());
+  store.read(0x1000,table,sizeof(table));
+
+  return(0);
+}
+*/
+
+// Defines
+#define LZ_Marker 0x4C
+#define LZ_HeaderSize 6
+#define LZ_WindowBits 10
+#define LZ_LengthBits (16 - LZ_WindowBits)
+#define LZ_MinMatch 3
+#define LZ_MaxMatch (LZ_MinMatch + (1 << LZ_LengthBits) - 1)
+
+/** CompressedStore Class
+ */
+class CompressedStore
+{
+public:
+  /**
+   * Constructor
+   * @param ep eeprom holding the blobs (EEPROM&)
+   * @return none
+   */
+  CompressedStore(EEPROM &ep);
+
+  /**
+   * Compress and write a blob
+   * @param address start address (uint32_t)
+   * @param data data to write (void *)
+   * @param size number of bytes to write (uint32_t)
+   * @param max_size size of the eeprom area available for the blob (uint32_t)
+   * @return number of bytes stored, header included, 0 on error (uint32_t)
+   */
+  uint32_t write(uint32_t address, void *data, uint32_t size, uint32_t max_size);
+
+  /**
+   * Read and decompress a blob
+   * @param address start address (uint32_t)
+   * @param data buffer for the data (void *)
+   * @param size buffer size in bytes (uint32_t)
+   * @return original size of the blob, 0 on error (uint32_t)
+   */
+  uint32_t read(uint32_t address, void *data, uint32_t size);
+
+  /**
+   * Get the original size of the last blob written or read
+   * @param none
+   * @return size in bytes (uint32_t)
+   */
+  uint32_t getOriginalSize(void);
+
+  /**
+   * Get the stored size, header included, of the last blob written or read
+   * @param none
+   * @return size in bytes (uint32_t)
+   */
+  uint32_t getStoredSize(void);
+
+  /**
+   * Get the compression ratio of the last blob written or read, original size / stored size
+   * @param none
+   * @return ratio in percent (uint32_t)
+   */
+  uint32_t getRatio(void);
+
+  /**
+   * Get the duration of the last write or read, bus included
+   * @param none
+   * @return duration in us (uint32_t)
+   */
+  uint32_t getTime(void);
+
+  /**
+   * Get the current error number (EEPROM_NoError if no error)
+   * @param  none
+   * @return none
+   */
+  uint8_t getError(void);
+
+  //---------- local variables ----------
+private:
+  EEPROM &_ep;                                      // EEPROM holding the blobs
+  uint8_t _errnum;                                  // Error number
+  uint32_t _original;                               // Last blob original size
+  uint32_t _stored;                                 // Last blob stored size
+  uint32_t _time;                                   // Last operation duration (us)
+  uint8_t _page[MAX_PAGE_SIZE];                     // Page buffer
+  uint32_t _address;                                // Eeprom address of the page buffer
+  uint32_t _end;                                    // End of the eeprom area
+  uint16_t _fill;                                   // Bytes in the page buffer
+  uint16_t _pos;                                    // Read position in the page buffer
+  bool put(const uint8_t *data, uint32_t size);     // Add bytes to the compressed stream
+  bool flush(void);                                 // Write the page buffer
+  bool get(uint8_t &data);                          // Next byte of the compressed stream
+  //-------------------------------------
+};
+#endif
@@ -0,0 +1,380 @@
+/***********************************************************
+Delta encoded log of numeric samples stored on an EEPROM.
+************************************************************/
+#include "delta_log.h"
+
+/**
+ * DeltaLog(EEPROM &ep, uint32_t address, uint32_t size)
+ *
+ * Constructor, no access is done to the eeprom (see mount)
+ * @param ep eeprom holding the log (EEPROM&)
+ * @param address start address of the log, page aligned (uint32_t)
+ * @param size log size in bytes, multiple of the page size (uint32_t)
+ * @return none
+ */
+DeltaLog::DeltaLog(EEPROM &ep, uint32_t address, uint32_t size) : _ep(ep)
+{
+  _errnum = EEPROM_NoError;
+  _address = address;
+  _page_size = ep.getPageSize();
+  _pages = size / _page_size;
+  _mounted = false;
+  _frames = 0;
+  _fill = 0;
+  _written = 0;
+  _count = 0;
+  _last = 0;
+  rewind();
+
+  if (address % _page_size || size % _page_size || !_pages)
+    _errnum = EEPROM_ParamError;
+  else if (address + size > ep.getSize())
+    _errnum = EEPROM_OutOfRange;
+}
+
+/**
+ * void mount(void)
+ *
+ * Find the last frame of the log with a binary search and reopen it for the next samples
+ * @param none
+ * @return none
+ */
+void DeltaLog::mount(void)
+{
+  uint32_t lo, hi, mid, z;
+  uint16_t count, i;
+  uint8_t shift;
+  int32_t key;
+
+  // Check error
+  if (_errnum)
+    return;
+
+  _mounted = true;
+  _frames = 0;
+  _fill = 0;
+  _written = 0;
+  _count = 0;
+  rewind();
+
+  // The valid frames are a prefix of the log (see clear)
+  if (!readFrame(0, count, key))
+    return;
+
+  lo = 0;
+  hi = _pages;
+  while (hi - lo > 1)
+  {
+    mid = (lo + hi) / 2;
+    if (readFrame(mid, count, key))
+      lo = mid;
+    else
+    {
+      if (_errnum)
+        return;
+      hi = mid;
+    }
+  }
+  _frames = lo + 1;
+
+  // Decode the last frame to find its end and its last sample
+  _ep.read(_address + lo * _page_size, (int8_t *)_page, _page_size);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return;
+  }
+
+  memcpy(&_count, _page, 2);
+  memcpy(&_last, _page + 2, 4);
+  _fill = DELTA_HeaderSize;
+  for (i = 1; i < _count; i++)
+  {
+    z = 0;
+    shift = 0;
+    do
+    {
+      // End of the page or corrupted varint (more than 32 bits)
+      if (_fill >= _page_size || shift == 7 * DELTA_MaxVarint)
+      {
+        _errnum = EEPROM_OutOfRange;
+        return;
+      }
+      z |= (uint32_t)(_page[_fill] & 0x7F) << shift;
+      shift += 7;
+    } while (_page[_fill++] & 0x80);
+    _last = (int32_t)((uint32_t)_last + ((z >> 1) ^ -(z & 1)));
+  }
+  _written = _fill;
+}
+
+/**
+ * bool append(int32_t value)
+ *
+ * Append a sample, the frame is programmed when the sample does not fit in its page
+ * @param value sample value (int32_t)
+ * @return true if appended, false if the log is full or on error (bool)
+ */
+bool DeltaLog::append(int32_t value)
+{
+  uint8_t varint[DELTA_MaxVarint];
+  uint8_t len = 0;
+  uint32_t z;
+
+  if (!_mounted)
+    mount();
+
+  // Check error
+  if (_errnum)
+    return (false);
+
+  // Zigzag varint of the delta, wrapping arithmetic
+  z = (uint32_t)value - (uint32_t)_last;
+  z = (z << 1) ^ (uint32_t)((int32_t)z >> 31);
+  do
+  {
+    varint[len++] = (z & 0x7F) | ((z > 0x7F) ? 0x80 : 0);
+    z >>= 7;
+  } while (z);
+
+  if (_frames && _fill + len <= _page_size)
+  {
+    memcpy(_page + _fill, varint, len);
+    _fill += len;
+    _count++;
+    _last = value;
+    return (true);
+  }
+
+  // New frame starting with a keyframe
+  flush();
+  if (_errnum || _frames >= _pages)
+    return (false);
+
+  _frames++;
+  _count = 1;
+  _last = value;
+  memcpy(_page + 2, &value, 4);
+  _fill = DELTA_HeaderSize;
+  _written = 0;
+
+  return (true);
+}
+
+/**
+ * void flush(void)
+ *
+ * Program the samples of the open frame not yet programmed, header included, in one page program
+ * @param none
+ * @return none
+ */
+void DeltaLog::flush(void)
+{
+  // Check error
+  if (_errnum || _fill == _written)
+    return;
+
+  memcpy(_page, &_count, 2);
+  _ep.write(_address + (_frames - 1) * _page_size, (int8_t *)_page, _fill);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return;
+  }
+  _written = _fill;
+}
+
+/**
+ * void clear(void)
+ *
+ * Empty the log, the frame headers are cleared from the last one so that
+ * the valid frames stay a prefix of the log if the clear is interrupted
+ * @param none
+ * @return none
+ */
+void DeltaLog::clear(void)
+{
+  uint16_t blank = 0;
+
+  if (!_mounted)
+    mount();
+
+  while (_frames && !_errnum)
+  {
+    _ep.write(_address + (_frames - 1) * _page_size, (int8_t *)&blank, 2);
+    if (_ep.getError() != EEPROM_NoError)
+    {
+      _errnum = _ep.getError();
+      return;
+    }
+    _frames--;
+  }
+
+  _fill = 0;
+  _written = 0;
+  _count = 0;
+  _last = 0;
+  rewind();
+}
+
+/**
+ * void rewind(void)
+ *
+ * Restart the reader at the first sample
+ * @param none
+ * @return none
+ */
+void DeltaLog::rewind(void)
+{
+  _read_frame = 0;
+  _read_address = 0;
+  _read_left = 0;
+  _read_value = 0;
+  _chunk_address = 0;
+  _chunk_fill = 0;
+}
+
+/**
+ * bool next(int32_t &value)
+ *
+ * Decode the next sample, the frames are read DELTA_ReadChunk bytes at a time
+ * @param value sample value (int32_t&)
+ * @return true if a sample is read, false at the end of the log or on error (bool)
+ */
+bool DeltaLog::next(int32_t &value)
+{
+  uint32_t z = 0;
+  uint8_t shift = 0;
+  uint8_t data;
+
+  if (!_mounted)
+    mount();
+
+  // Check error
+  if (_errnum)
+    return (false);
+
+  // Keyframe of the next frame
+  if (!_read_left)
+  {
+    if (_read_frame >= _frames || !readFrame(_read_frame, _read_left, _read_value))
+      return (false);
+
+    _read_address = _address + _read_frame * _page_size + DELTA_HeaderSize;
+    _read_frame++;
+    _read_left--;
+    value = _read_value;
+    return (true);
+  }
+
+  do
+  {
+    // Corrupted varint (more than 32 bits)
+    if (shift == 7 * DELTA_MaxVarint)
+    {
+      _errnum = EEPROM_OutOfRange;
+      return (false);
+    }
+    if (!getByte(data))
+      return (false);
+    z |= (uint32_t)(data & 0x7F) << shift;
+    shift += 7;
+  } while (data & 0x80);
+
+  _read_value = (int32_t)((uint32_t)_read_value + ((z >> 1) ^ -(z & 1)));
+  _read_left--;
+  value = _read_value;
+
+  return (true);
+}
+
+/**
+ * uint32_t getFrames(void)
+ *
+ * Get the number of frames (pages) used
+ * @param none
+ * @return number of frames (uint32_t)
+ */
+uint32_t DeltaLog::getFrames(void)
+{
+  if (!_mounted)
+    mount();
+
+  return (_frames);
+}
+
+/**
+ * uint8_t getError(void)
+ *
+ * Get the current error number (EEPROM_NoError if no error)
+ * @param none
+ * @return none
+ */
+uint8_t DeltaLog::getError(void)
+{
+  return (_errnum);
+}
+
+/**
+ * bool readFrame(uint32_t frame, uint16_t &count, int32_t &key)
+ *
+ * Read a frame header and check its number of samples
+ * @param frame frame index (uint32_t)
+ * @param count number of samples (uint16_t&)
+ * @param key keyframe sample (int32_t&)
+ * @return true if the frame is valid, overwise false (bool)
+ */
+bool DeltaLog::readFrame(uint32_t frame, uint16_t &count, int32_t &key)
+{
+  uint8_t data[DELTA_HeaderSize];
+
+  _ep.read(_address + frame * _page_size, (int8_t *)data, DELTA_HeaderSize);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  memcpy(&count, data, 2);
+  memcpy(&key, data + 2, 4);
+
+  // Cleared (0) and blank (0xFFFF) headers are rejected
+  return (count && count <= _page_size - DELTA_HeaderSize + 1);
+}
+
+/**
+ * bool getByte(uint8_t &data)
+ *
+ * Get the next byte of the frame being decoded
+ * @param data next byte (uint8_t&)
+ * @return true if read, overwise false (bool)
+ */
+bool DeltaLog::getByte(uint8_t &data)
+{
+  uint32_t end;
+
+  if (_read_address < _chunk_address || _read_address >= _chunk_address + _chunk_fill)
+  {
+    // Samples never cross the end of their frame
+    end = _address + _read_frame * _page_size;
+    if (_read_address >= end)
+    {
+      _errnum = EEPROM_OutOfRange;
+      return (false);
+    }
+
+    _chunk_address = _read_address;
+    _chunk_fill = (end - _read_address < DELTA_ReadChunk) ? end - _read_address : DELTA_ReadChunk;
+    _ep.read(_chunk_address, (int8_t *)_chunk, _chunk_fill);
+    if (_ep.getError() != EEPROM_NoError)
+    {
+      _errnum = _ep.getError();
+      _chunk_fill = 0;
+      return (false);
+    }
+  }
+
+  data = _chunk[_read_address++ - _chunk_address];
+
+  return (true);
+}
@@ -0,0 +1,155 @@
+#ifndef __DELTA_LOG__H_
+#define __DELTA_LOG__H_
+
+/***********************************************************
+Delta encoded log of numeric samples stored on an EEPROM.
+
+Samples are stored as the zigzag varint of their difference with the
+previous sample, so slowly changing values take 1 or 2 bytes instead of
+4. The log is a sequence of frames, one per page : every frame starts
+with a full keyframe sample and can be decoded on its own.
+
+append() encodes into the page buffer of the open frame, the frame is
+programmed when the next sample does not fit in the page or on flush()
+(a flush programs the frame header and the new samples in one page
+program). The reader decodes the frames with short sequential reads and
+only sees the flushed samples.
+
+Frame layout (little endian) :
+  - number of samples, keyframe included (uint16_t)
+  - keyframe sample (int32_t)
+  - zigzag varint deltas, 7 bits per byte, lsb first, bit 7 set when more bytes follow
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom.h"
+#include "delta_log.h"
+
+EEPROM ep(p9,p10,0,EEPROM::T24C256);
+DeltaLog temperature(ep,0x4000,0x4000);
+AnalogIn sensor(p20);
+
+int main()
+{
+  int32_t value;
+
+  temperature.mount();
+  while(temperature.append(sensor.read_u16())) {
+    if(...) temperature.flush();
+    wait(60);
+  }
+
+  temperature.rewind();
+  while(temperature.next(value))
+    printf("%d\n",value);
+
+  return(0);
+}
+*/
+
+// Defines
+#define DELTA_HeaderSize 6
+#define DELTA_MaxVarint 5
+#define DELTA_ReadChunk 16
+
+/** DeltaLog Class
+ */
+class DeltaLog
+{
+public:
+  /**
+   * Constructor, no access is done to the eeprom (see mount)
+   * @param ep eeprom holding the log (EEPROM&)
+   * @param address start address of the log, page aligned (uint32_t)
+   * @param size log size in bytes, multiple of the page size (uint32_t)
+   * @return none
+   */
+  DeltaLog(EEPROM &ep, uint32_t address, uint32_t size);
+
+  /**
+   * Find the last frame of the log and reopen it for the next samples
+   * @param none
+   * @return none
+   */
+  void mount(void);
+
+  /**
+   * Append a sample
+   * @param value sample value (int32_t)
+   * @return true if appended, false if the log is full or on error (bool)
+   */
+  bool append(int32_t value);
+
+  /**
+   * Program the samples of the open frame not yet programmed
+   * @param none
+   * @return none
+   */
+  void flush(void);
+
+  /**
+   * Empty the log, one page program per frame used
+   * @param none
+   * @return none
+   */
+  void clear(void);
+
+  /**
+   * Restart the reader at the first sample
+   * @param none
+   * @return none
+   */
+  void rewind(void);
+
+  /**
+   * Decode the next sample
+   * @param value sample value (int32_t&)
+   * @return true if a sample is read, false at the end of the log or on error (bool)
+   */
+  bool next(int32_t &value);
+
+  /**
+   * Get the number of frames (pages) used
+   * @param none
+   * @return number of frames (uint32_t)
+   */
+  uint32_t getFrames(void);
+
+  /**
+   * Get the current error number (EEPROM_NoError if no error)
+   * @param  none
+   * @return none
+   */
+  uint8_t getError(void);
+
+  //---------- local variables ----------
+private:
+  EEPROM &_ep;                                      // EEPROM holding the log
+  uint32_t _address;                                // Log start address
+  uint32_t _pages;                                  // Number of pages
+  uint16_t _page_size;                              // Page size in bytes
+  uint8_t _errnum;                                  // Error number
+  bool _mounted;                                    // mount done
+  uint32_t _frames;                                 // Number of frames, open frame included
+  uint8_t _page[MAX_PAGE_SIZE];                     // Open frame
+  uint16_t _fill;                                   // Bytes in the open frame
+  uint16_t _written;                                // Bytes of the open frame programmed
+  uint16_t _count;                                  // Samples in the open frame
+  int32_t _last;                                    // Last sample appended
+  uint32_t _read_frame;                             // Reader next frame
+  uint32_t _read_address;                           // Reader next byte address
+  uint16_t _read_left;                              // Reader samples left in the frame
+  int32_t _read_value;                              // Reader last sample
+  uint8_t _chunk[DELTA_ReadChunk];                  // Reader buffer
+  uint32_t _chunk_address;                          // Reader buffer address
+  uint8_t _chunk_fill;                              // Bytes in the reader buffer
+  bool readFrame(uint32_t frame, uint16_t &count, int32_t &key); // Read and check a frame header
+  bool getByte(uint8_t &data);                      // Reader next byte
+  //-------------------------------------
+};
+#endif
@@ -29,11 +29,78 @@ Version: 1.0
 #define BIT_TEST(x, n) (x & (0x01 << n))
 #define BIT_CLEAR(x, n) (x = x & ~(0x01 << n))
 
-const char *const EEPROM::_name[] = {"24C01", "24C02", "24C04", "24C08", "24C16", "24C32",
-                                     "24C64", "24C128", "24C256", "24C512", "24C1024", "24C1025", "M24M02"};
+// Device descriptors, in the order of _types
+static constexpr EEPROMDescriptor _descriptors[] = {
+    // name        size    page  addr  block shift  chip  shift  tWR  spi
+    {"24C01",      128,    8,    1,    0,    1,     7,    1,     5,   false},
+    {"24C02",      256,    8,    1,    0,    1,     7,    1,     5,   false},
+    {"24C04",      512,    16,   1,    1,    1,     7,    1,     5,   false},
+    {"24C08",      1024,   16,   1,    2,    1,     7,    1,     5,   false},
+    {"24C16",      2048,   16,   1,    3,    1,     7,    1,     5,   false},
+    {"24C32",      4096,   32,   2,    0,    1,     7,    1,     5,   false},
+    {"24C64",      8192,   32,   2,    0,    1,     7,    1,     5,   false},
+    {"24C128",     16384,  64,   2,    0,    1,     7,    1,     5,   false},
+    {"24C256",     32768,  64,   2,    0,    1,     7,    1,     5,   false},
+    {"24C512",     65536,  128,  2,    0,    1,     7,    1,     5,   false},
+    {"24C1024",    131072, 128,  2,    1,    1,     3,    1,     5,   false},
+    {"24C1025",    131072, 128,  2,    1,    3,     3,    1,     5,   false},
+    {"M24M02",     262144, 256,  2,    2,    1,     1,    3,     10,  false},
+    {"MB85RC04",   512,    0,    1,    1,    1,     7,    1,     0,   false},
+    {"MB85RC16",   2048,   0,    1,    3,    1,     7,    1,     0,   false},
+    {"MB85RC64",   8192,   0,    2,    0,    1,     7,    1,     0,   false},
+    {"MB85RC128",  16384,  0,    2,    0,    1,     7,    1,     0,   false},
+    {"MB85RC256",  32768,  0,    2,    0,    1,     7,    1,     0,   false},
+    {"MB85RC512",  65536,  0,    2,    0,    1,     7,    1,     0,   false},
+    {"MB85RC1M",   131072, 0,    2,    1,    1,     3,    2,     0,   false},
+    {"25LC010",    128,    16,   1,    0,    3,     0,    0,     5,   true},
+    {"25LC020",    256,    16,   1,    0,    3,     0,    0,     5,   true},
+    {"25LC040",    512,    16,   1,    1,    3,     0,    0,     5,   true},
+    {"25LC080",    1024,   16,   2,    0,    3,     0,    0,     5,   true},
+    {"25LC160",    2048,   16,   2,    0,    3,     0,    0,     5,   true},
+    {"25LC320",    4096,   32,   2,    0,    3,     0,    0,     5,   true},
+    {"25LC640",    8192,   32,   2,    0,    3,     0,    0,     5,   true},
+    {"25LC128",    16384,  64,   2,    0,    3,     0,    0,     5,   true},
+    {"25LC256",    32768,  64,   2,    0,    3,     0,    0,     5,   true},
+    {"25LC512",    65536,  128,  2,    0,    3,     0,    0,     5,   true},
+    {"25LC1024",   131072, 256,  3,    0,    3,     0,    0,     6,   true},
+    {"M24M01",     131072, 256,  2,    1,    1,     3,    2,     5,   false}};
+
+// Device model of each descriptor
+static constexpr EEPROM::TypeEeprom _types[] = {
+    EEPROM::T24C01, EEPROM::T24C02, EEPROM::T24C04, EEPROM::T24C08, EEPROM::T24C16,
+    EEPROM::T24C32, EEPROM::T24C64, EEPROM::T24C128, EEPROM::T24C256, EEPROM::T24C512,
+    EEPROM::T24C1024, EEPROM::T24C1025, EEPROM::M24M02,
+    EEPROM::MB85RC04, EEPROM::MB85RC16, EEPROM::MB85RC64, EEPROM::MB85RC128, EEPROM::MB85RC256,
+    EEPROM::MB85RC512, EEPROM::MB85RC1M,
+    EEPROM::T25LC010, EEPROM::T25LC020, EEPROM::T25LC040, EEPROM::T25LC080, EEPROM::T25LC160,
+    EEPROM::T25LC320, EEPROM::T25LC640, EEPROM::T25LC128, EEPROM::T25LC256, EEPROM::T25LC512,
+    EEPROM::T25LC1024, EEPROM::M24M01};
+
+#define DESCRIPTOR_Count (sizeof(_descriptors) / sizeof(_descriptors[0]))
+
+static_assert(sizeof(_types) / sizeof(_types[0]) == DESCRIPTOR_Count, "one TypeEeprom per descriptor");
+
+// Descriptor of an unknown model : its size 0 makes the constructors report EEPROM_ParamError
+static constexpr EEPROMDescriptor _unknown = {"", 0, 0, 0, 0, 0, 0, 0, 0, false};
 
 /**
- * EEPROM(PinName sda, PinName scl, uint8_t address, TypeEeprom type) : _i2c(sda, scl)
+ * size_t descriptorIndex(EEPROM::TypeEeprom type, size_t i)
+ *
+ * Index of a device model in the descriptor table
+ * @param type eeprom type (TypeEeprom)
+ * @param i first index to search (size_t)
+ * @return index, DESCRIPTOR_Count if the model is unknown (size_t)
+ */
+static constexpr size_t descriptorIndex(EEPROM::TypeEeprom type, size_t i = 0)
+{
+  return ((i == DESCRIPTOR_Count || _types[i] == type) ? i : descriptorIndex(type, i + 1));
+}
+
+static_assert(descriptorIndex(EEPROM::T24C64) == 6 && descriptorIndex(EEPROM::M24M01) == DESCRIPTOR_Count - 1,
+              "TypeEeprom to descriptor mapping");
+
+/**
+ * EEPROM(PinName sda, PinName scl, uint8_t address, TypeEeprom type)
  *
  * Constructor, initialize the eeprom on i2c interface.
  * @param sda sda i2c pin (PinName)
@@ -42,114 +109,92 @@ const char *const EEPROM::_name[] = {"24C01", "24C02", "24C04", "24C08", "24C16"
  * @param type eeprom type (TypeEeprom)
  * @return none
  */
-EEPROM::EEPROM(PinName sda, PinName scl, uint8_t address, TypeEeprom type) : _i2c(sda, scl)
+EEPROM::EEPROM(PinName sda, PinName scl, uint8_t address, TypeEeprom type)
+    : EEPROM(sda, scl, address, getDescriptor(type))
 {
+}
 
-  _errnum = EEPROM_NoError;
-  _type = type;
+/**
+ * EEPROM(PinName sda, PinName scl, uint8_t address, const EEPROMDescriptor &desc)
+ *
+ * Constructor for a device described by the caller, initialize the eeprom on i2c interface.
+ * @param sda sda i2c pin (PinName)
+ * @param scl scl i2c pin (PinName)
+ * @param address eeprom address, according to eeprom type (uint8_t)
+ * @param desc device descriptor, copied (const EEPROMDescriptor&)
+ * @return none
+ */
+EEPROM::EEPROM(PinName sda, PinName scl, uint8_t address, const EEPROMDescriptor &desc)
+    : EEPROM(desc)
+{
+  uint8_t block_mask;
+
+  _i2c = new I2C(sda, scl);
+
+  // Check descriptor
+  if (desc.spi || desc.address_bytes < 1 || desc.address_bytes > 2)
+    _errnum = EEPROM_ParamError;
 
   // Check address range
-  _address = address;
-  switch (type)
-  {
-  case T24C01:
-  case T24C02:
-    if (address > 7)
-    {
-      _errnum = EEPROM_BadAddress;
-    }
-    _address = _address << 1;
-    _page_write = 8;
-    _page_block_number = 1;
-    break;
-  case T24C04:
-    if (address > 7)
-    {
-      _errnum = EEPROM_BadAddress;
-    }
-    _address = (_address & 0xFE) << 1;
-    _page_write = 16;
-    _page_block_number = 2;
-    break;
-  case T24C08:
-    if (address > 7)
-    {
-      _errnum = EEPROM_BadAddress;
-    }
-    _address = (_address & 0xFC) << 1;
-    _page_write = 16;
-    _page_block_number = 4;
-    break;
-  case T24C16:
-    _address = 0;
-    _page_write = 16;
-    _page_block_number = 8;
-    break;
-  case T24C32:
-  case T24C64:
-    if (address > 7)
-    {
-      _errnum = EEPROM_BadAddress;
-    }
-    _address = _address << 1;
-    _page_write = 32;
-    _page_block_number = 1;
-    break;
-  case T24C128:
-  case T24C256:
-    if (address > 7)
-    {
-      _errnum = EEPROM_BadAddress;
-    }
-    _address = _address << 1;
-    _page_write = 64;
-    _page_block_number = 1;
-    break;
-  case T24C512:
-    if (address > 7)
-    {
-      _errnum = EEPROM_BadAddress;
-    }
-    _address = _address << 1;
-    _page_write = 128;
-    _page_block_number = 1;
-    break;
-  case T24C1024:
-    if (address > 3)
-    {
-      _errnum = EEPROM_BadAddress;
-    }
-    _address = (_address & 0xFE) << 1;
-    _page_write = 128;
-    _page_block_number = 2;
-    break;
-  case T24C1025:
-    if (address > 3)
-    {
-      _errnum = EEPROM_BadAddress;
-    }
-    _address = _address << 1;
-    _page_write = 128;
-    _page_block_number = 2;
-    break;
-  case M24M02:
-    if (address > 1)
-    {
-      _errnum = EEPROM_BadAddress;
-    }
-    _address = _address << 3;
-    _page_write = 256;
-    _page_block_number = 4;
-    break;  
-  }
+  if (address > desc.chip_address_max)
+    _errnum = EEPROM_BadAddress;
 
-  // Size in bytes
-  _size = _type;
-  if (_type == T24C1025)
-    _size = T24C1024;
+  // Address pins not used by the chip are replaced by the page block bits
+  block_mask = ((1 << desc.block_bits) - 1) << desc.block_shift;
+  _address = (address << desc.chip_address_shift) & ~block_mask & 0x0E;
+
+  // Set I2C frequency, 9 clocks per byte with the acknowledge
+  _i2c->frequency(400000);
+  _bus_frequency = 400000;
+  _bus_clocks = 9;
+}
+
+/**
+ * EEPROM(const EEPROMDescriptor &desc)
+ *
+ * Constructor for the other bus backends, the backend sets the bus
+ * @param desc device descriptor, copied (const EEPROMDescriptor&)
+ * @return none
+ */
+EEPROM::EEPROM(const EEPROMDescriptor &desc) : _i2c(NULL)
+{
+  _errnum = EEPROM_NoError;
+  _desc = desc;
+  _address = 0;
+  _size = desc.size;
+  _read_while_write = false;
+  _busy = false;
+  _pending_address = 0;
+  _pending_size = 0;
+  _budget_rate = 0;
+  _budget_suspended = false;
+  _changed = NULL;
+  _changed_store = EEPROM_NoStore;
+  _changed_size = 0;
+  _bus_frequency = 400000;
+  _bus_clocks = 9;
+
+  // Devices without page limit are written by chunks of MAX_PAGE_SIZE when a buffer is needed
+  _page_write = desc.page_size;
+  if (_page_write == 0)
+    _page_write = MAX_PAGE_SIZE;
+
+  // Check descriptor
+  if (desc.page_size > MAX_PAGE_SIZE || desc.size == 0)
+    _errnum = EEPROM_ParamError;
+}
 
-  // Set I2C frequency
-  _i2c.frequency(400000);
+/**
+ * ~EEPROM()
+ *
+ * Destructor, release the i2c interface
+ * @param none
+ * @return none
+ */
+EEPROM::~EEPROM()
+{
+  delete _i2c;
+  free(_changed);
 }
 
 /**
@@ -162,12 +207,6 @@ EEPROM::EEPROM(PinName sda, PinName scl, uint8_t address, TypeEeprom type) : _i2
  */
 void EEPROM::write(uint32_t address, int8_t data)
 {
-  uint8_t page_block;
-  uint8_t addr;
-  uint8_t cmd[3];
-  int len;
-  int ack;
-
   // Check error
   if (_errnum)
     return;
@@ -179,61 +218,27 @@ void EEPROM::write(uint32_t address, int8_t data)
     return;
   }
 
-  // Compute page block
-  page_block = 0;
-  if (_type < T24C32)
-  {
-    page_block = address / 0xFF;
-    address %= 0xFF;
-  }
-  else if (_type > T24C512)
-  {
-    page_block = address / 0xFFFF;
-    address %= 0xFFFF;
-  }
-
-  // Device address
-  addr = EEPROM_Address | _address | (page_block << 1);
-
-  if (_type < T24C32)
-  {
-    len = 2;
-
-    // Word address
-    cmd[0] = (uint8_t)address;
-
-    // Data
-    cmd[1] = (uint8_t)data;
-  }
-  else
-  {
-    len = 3;
-
-    // First word address (MSB)
-    cmd[0] = (uint8_t)(address >> 8);
-
-    // Second word address (LSB)
-    cmd[1] = (uint8_t)address;
+  // Mark the page before the program, the bitmap store is written first
+  track(address, 1);
+  if (_errnum)
+    return;
 
-    // Data
-    cmd[2] = (uint8_t)data;
-  }
+  // Wait end of the previous write
+  waitWrite();
 
-  ack = _i2c.write((int)addr, (char *)cmd, len);
-  if (ack != 0)
-  {
-    _errnum = EEPROM_I2cError;
+  throttle(_desc.address_bytes + 2, true);
+  busWrite(address, &data, 1);
+  if (_errnum)
     return;
-  }
 
-  // Wait end of write
-  ready();
+  // Wait end of write or keep the byte for the reads during the write cycle
+  endWrite(address, 1);
 }
 
 /**
  * void write(uint32_t address, int8_t data[], uint32_t length)
  *
- * Write array of bytes (use the page mode)
+ * Write array of bytes (use the page mode, one transaction per MAX_PAGE_SIZE frame on FRAM)
  * @param address start address (uint32_t)
  * @param data bytes array to write (int8_t[])
  * @param size number of bytes to write (uint32_t)
@@ -241,15 +246,11 @@ void EEPROM::write(uint32_t address, int8_t data)
  */
 void EEPROM::write(uint32_t address, int8_t data[], uint32_t length)
 {
-  uint8_t page_block;
-  uint8_t addr = 0;
-  uint8_t blocs;
-  uint16_t remain;
-  uint8_t i, j;
-  uint8_t cmd[MAX_PAGE_SIZE + 2];
-  int ack;
+  uint32_t blocs;
+  uint32_t remain;
+  uint32_t i;
+  uint16_t j;
   uint32_t written_cnt = 0;
-  uint8_t len;
 
   // Check error
   if (_errnum)
@@ -269,6 +270,22 @@ void EEPROM::write(uint32_t address, int8_t data[], uint32_t length)
     return;
   }
 
+  // No page limit (FRAM) : no write cycle, one locked transaction per MAX_PAGE_SIZE frame
+  if (_desc.page_size == 0)
+  {
+    track(address, length);
+    while (length && !_errnum)
+    {
+      j = (length < _page_write) ? length : _page_write;
+      throttle(_desc.address_bytes + 1 + j, true);
+      busWrite(address, data, j);
+      address += j;
+      data += j;
+      length -= j;
+    }
+    return;
+  }
+
   // Consider offset for correct number of blocs
   auto offset = address % _page_write;
 
@@ -286,61 +303,89 @@ void EEPROM::write(uint32_t address, int8_t data[], uint32_t length)
 
   for (i = 0; i < blocs; i++)
   {
-    // Compute page block
-    page_block = 0;
-    if (_type < T24C32)
-    {
-      page_block = address / 0xFF;
-      address %= 0xFF;
-    }
-    else if (_type > T24C512)
-    {
-      page_block = address / 0xFFFF;
-      address %= 0xFFFF;
-    }
-
-    // Device address
-    addr = EEPROM_Address | _address | (page_block << 1);
-
-    // Depending on the EEPROM the address can either be on one or two bytes
-    if (_type < T24C32)
-      len = 1;
-    else
-      len = 2;
-
     // Offset from start of page
     auto page_offset = address % _page_write;
 
-    // Set the address part of cmd, in the case of the address on 2 bytes the MSB goes in the first element of cmd
-    for (auto l = 0; l < len; l++)
-      cmd[l] = (uint8_t)((address - page_offset) >> (8 * (len - l - 1)));
+    // Up to the page end or until there is data to write. A partial write starts at
+    // the first touched byte so the rest of the page is left untouched by the chip
+    j = _page_write - page_offset;
+    if (j > bytes_to_write)
+      j = bytes_to_write;
 
-    // In case this is a partial write, read the whole page to refresh the untouched values
-    if (page_offset != 0 || bytes_to_write < _page_write)
-      read(address - page_offset, cmd + len, _page_write);
+    // Mark the page before the program, the bitmap store is written first
+    track(address, j);
+    if (_errnum)
+      return;
 
-    // Loop  up to the page end or until there is data to read
-    for (j = 0; (j < _page_write - page_offset) && (j < bytes_to_write); j++)
-      cmd[j + page_offset + len] = (uint8_t)data[written_cnt + j];
+    // Wait end of the previous write
+    waitWrite();
 
     // Write data
-    ack = _i2c.write((int)addr, (char *)cmd, _page_write + len);
-    if (ack != 0)
-    {
-      _errnum = EEPROM_I2cError;
+    throttle(_desc.address_bytes + 1 + j, true);
+    busWrite(address, data + written_cnt, j);
+    if (_errnum)
       return;
-    }
 
-    // Wait end of write
-    ready();
+    // Wait end of write or keep the page for the reads during the write cycle
+    endWrite(address, j);
 
     // Increment address and update the number of bytes written and to be written
-    written_cnt += (_page_write - page_offset);
+    written_cnt += j;
     address = start_address + written_cnt;
     bytes_to_write = length - written_cnt;
   }
 }
 
+/**
+ * void write(uint32_t address, int8_t header[], uint32_t header_size, int8_t data[], uint32_t size)
+ *
+ * Write a header followed by data (use the page mode) : the header and the start of the data
+ * up to the end of the header page are assembled in the member page buffer and written as one
+ * page program, the rest of the data is written from the caller buffer
+ * @param address start address (uint32_t)
+ * @param header bytes array to write first (int8_t[])
+ * @param header_size number of header bytes (uint32_t)
+ * @param data bytes array to write after the header (int8_t[])
+ * @param size number of data bytes (uint32_t)
+ * @return none
+ */
+void EEPROM::write(uint32_t address, int8_t header[], uint32_t header_size, int8_t data[], uint32_t size)
+{
+  uint32_t count;
+
+  // Check error
+  if (_errnum)
+    return;
+
+  // Check address
+  if (!checkAddress(address) || !checkAddress(address + header_size + size - 1))
+  {
+    _errnum = EEPROM_OutOfRange;
+    return;
+  }
+
+  // Data bytes that fit in the header page
+  count = _page_write - address % _page_write;
+  if (header_size >= count)
+  {
+    // The header fills its page : nothing to assemble
+    write(address, header, header_size);
+    count = 0;
+  }
+  else
+  {
+    count -= header_size;
+    if (count > size)
+      count = size;
+    memcpy(_buffer, header, header_size);
+    memcpy(_buffer + header_size, data, count);
+    write(address, _buffer, header_size + count);
+  }
+
+  if (count < size)
+    write(address + header_size + count, data + count, size - count);
+}
+
 /**
  * void write(uint32_t address, int16_t data)
  *
@@ -473,12 +518,6 @@ void EEPROM::write(uint32_t address, void *data, uint32_t size)
  */
 void EEPROM::read(uint32_t address, int8_t &data)
 {
-  uint8_t page_block;
-  uint8_t addr;
-  uint8_t cmd[2];
-  uint8_t len;
-  int ack;
-
   // Check error
   if (_errnum)
     return;
@@ -490,47 +529,12 @@ void EEPROM::read(uint32_t address, int8_t &data)
     return;
   }
 
-  // Compute page block
-  page_block = 0;
-  if (_type < T24C32)
-  {
-    page_block = address / 0xFF;
-    address %= 0xFF;
-  }
-  else if (_type > T24C512)
-  {
-    page_block = address / 0xFFFF;
-    address %= 0xFFFF;
-  }
-
-  // Device address
-  addr = EEPROM_Address | _address | (page_block << 1);
-
-  // Depending on the EEPROM the address can either be on one or two bytes
-  if (_type < T24C32)
-    len = 1;
-  else
-    len = 2;
-
-  // Set the address part of cmd, in the case of the address on 2 bytes the MSB goes in the first element of cmd
-  for (auto l = 0; l < len; l++)
-    cmd[l] = (uint8_t)((address) >> (8 * (len - l - 1)));
-
-  // Write command
-  ack = _i2c.write((int)addr, (char *)cmd, len, true);
-  if (ack != 0)
-  {
-    _errnum = EEPROM_I2cError;
+  // Served from the page being written or wait its end of write
+  if (readPending(address, &data, 1))
     return;
-  }
 
-  // Read data
-  ack = _i2c.read((int)addr, (char *)&data, sizeof(data));
-  if (ack != 0)
-  {
-    _errnum = EEPROM_I2cError;
-    return;
-  }
+  throttle(_desc.address_bytes + 3, true);
+  busRead(address, &data, 1);
 }
 
 /**
@@ -544,12 +548,6 @@ void EEPROM::read(uint32_t address, int8_t &data)
  */
 void EEPROM::read(uint32_t address, int8_t *data, uint32_t size)
 {
-  uint8_t page_block;
-  uint8_t addr;
-  uint8_t cmd[2];
-  uint8_t len;
-  int ack;
-
   // Check error
   if (_errnum)
     return;
@@ -568,47 +566,12 @@ void EEPROM::read(uint32_t address, int8_t *data, uint32_t size)
     return;
   }
 
-  // Compute page block
-  page_block = 0;
-  if (_type < T24C32)
-  {
-    page_block = address / 0xFF;
-    address %= 0xFF;
-  }
-  else if (_type > T24C512)
-  {
-    page_block = address / 0xFFFF;
-    address %= 0xFFFF;
-  }
-
-  // Device address
-  addr = EEPROM_Address | _address | (page_block << 1);
-
-  // Depending on the EEPROM the address can either be on one or two bytes
-  if (_type < T24C32)
-    len = 1;
-  else
-    len = 2;
-
-  // Set the address part of cmd, in the case of the address on 2 bytes the MSB goes in the first element of cmd
-  for (auto l = 0; l < len; l++)
-    cmd[l] = (uint8_t)((address) >> (8 * (len - l - 1)));
-
-  // Write command
-  ack = _i2c.write((int)addr, (char *)cmd, len, true);
-  if (ack != 0)
-  {
-    _errnum = EEPROM_I2cError;
+  // Served from the page being written or wait its end of write
+  if (readPending(address, data, size))
     return;
-  }
 
-  // Sequential read
-  ack = _i2c.read((int)addr, (char *)data, size);
-  if (ack != 0)
-  {
-    _errnum = EEPROM_I2cError;
-    return;
-  }
+  throttle(_desc.address_bytes + 2 + size, true);
+  busRead(address, data, size);
 }
 
 /**
@@ -620,24 +583,15 @@ void EEPROM::read(uint32_t address, int8_t *data, uint32_t size)
  */
 void EEPROM::read(int8_t &data)
 {
-  uint8_t page_block;
-  uint8_t addr;
-  int ack;
-
   // Check error
   if (_errnum)
     return;
 
-  // Device address
-  addr = EEPROM_Address | _address;
+  // Wait end of the previous write
+  waitWrite();
 
-  // Read data
-  ack = _i2c.read((int)addr, (char *)&data, sizeof(data));
-  if (ack != 0)
-  {
-    _errnum = EEPROM_I2cError;
-    return;
-  }
+  throttle(2, true);
+  busReadCurrent(data);
 }
 
 /**
@@ -764,63 +718,583 @@ void EEPROM::read(uint32_t address, void *data, uint32_t size)
 }
 
 /**
- * void clear(void)
+ * void fill(uint32_t address, int8_t data, uint32_t size)
  *
- * Clear eeprom (write with 0)
- * @param none
+ * Fill a range with a byte value (use the page mode)
+ * @param address start address (uint32_t)
+ * @param data byte value (int8_t)
+ * @param size number of bytes to fill (uint32_t)
  * @return none
  */
-void EEPROM::clear(void)
+void EEPROM::fill(uint32_t address, int8_t data, uint32_t size)
 {
-  int32_t data;
-  uint32_t i;
+  uint32_t count;
+
+  // Check error
+  if (_errnum)
+    return;
+
+  // Check address
+  if (!checkAddress(address + size - 1))
+  {
+    _errnum = EEPROM_OutOfRange;
+    return;
+  }
 
-  data = 0;
+  // Member page buffer, nothing on the caller stack
+  memset(_buffer, data, _page_write);
 
-  for (i = 0; i < _size / 4; i++)
+  // Page aligned chunks, so that every chunk is a single page program
+  while (size && !_errnum)
   {
-    write((uint32_t)(i * 4), data);
+    count = _page_write - address % _page_write;
+    if (count > size)
+      count = size;
+
+    write(address, _buffer, count);
+
+    address += count;
+    size -= count;
   }
 }
 
 /**
- * void ready(void)
+ * void clear(void)
  *
- * Wait eeprom ready
+ * Clear eeprom (write with 0)
  * @param none
  * @return none
  */
-void EEPROM::ready(void)
+void EEPROM::clear(void)
 {
-  int ack;
-  uint8_t addr;
-  uint8_t cmd[2];
+  fill(0, 0, _size);
+}
+
+/**
+ * uint32_t checksum(uint32_t address, uint32_t size, ChecksumAlgo algo)
+ *
+ * Checksum of a region, streamed through a EEPROM_ChecksumBuffer bytes buffer
+ * @param address start address (uint32_t)
+ * @param size number of bytes (uint32_t)
+ * @param algo CRC-32 (IEEE 802.3) or FNV-1a 32 bits hash (ChecksumAlgo)
+ * @return checksum (uint32_t)
+ */
+uint32_t EEPROM::checksum(uint32_t address, uint32_t size, ChecksumAlgo algo)
+{
+  // CRC-32 reflected polynomial 0xEDB88320, one nibble per step
+  static const uint32_t crc_table[16] = {
+      0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+      0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+  uint8_t buffer[EEPROM_ChecksumBuffer];
+  uint32_t sum, n, i;
+#ifdef EEPROM_HW_CRC
+  MbedCRC<POLY_32BIT_ANSI, 32> crc;
+#endif
 
   // Check error
   if (_errnum)
-    return;
+    return (0);
 
-  // Device address
-  addr = EEPROM_Address | _address;
+  // Check address
+  if (!checkAddress(address) || !checkAddress(address + size - 1))
+  {
+    _errnum = EEPROM_OutOfRange;
+    return (0);
+  }
 
-  cmd[0] = 0;
+  sum = (algo == ChecksumCRC32) ? 0xFFFFFFFF : 0x811C9DC5;
+#ifdef EEPROM_HW_CRC
+  if (algo == ChecksumCRC32)
+    crc.compute_partial_start(&sum);
+#endif
 
-  // Wait end of write
-  do
+  while (size && !_errnum)
   {
-    ack = _i2c.write((int)addr, (char *)cmd, 0);
-    // wait(0.5);
-  } while (ack != 0);
-}
+    n = (size < EEPROM_ChecksumBuffer) ? size : EEPROM_ChecksumBuffer;
+    read(address, (int8_t *)buffer, n);
 
-/**
- * uint32_t getSize(void)
- *
- * Get eeprom size in bytes
- * @param  none
- * @return size in bytes (uint32_t)
- */
-uint32_t EEPROM::getSize(void)
+    if (algo == ChecksumFNV1a)
+    {
+      for (i = 0; i < n; i++)
+        sum = (sum ^ buffer[i]) * 0x01000193;
+    }
+    else
+    {
+#ifdef EEPROM_HW_CRC
+      crc.compute_partial(buffer, n, &sum);
+#else
+      for (i = 0; i < n; i++)
+      {
+        sum ^= buffer[i];
+        sum = (sum >> 4) ^ crc_table[sum & 0x0F];
+        sum = (sum >> 4) ^ crc_table[sum & 0x0F];
+      }
+#endif
+    }
+
+    address += n;
+    size -= n;
+  }
+
+  if (_errnum)
+    return (0);
+
+  if (algo == ChecksumCRC32)
+  {
+#ifdef EEPROM_HW_CRC
+    crc.compute_partial_stop(&sum);
+#else
+    sum = ~sum;
+#endif
+  }
+
+  return (sum);
+}
+
+/**
+ * uint32_t compare(uint32_t address, const void *data, uint32_t size)
+ *
+ * Compare a region with a buffer, streamed through a EEPROM_ChecksumBuffer bytes buffer, stops at the first difference
+ * @param address start address (uint32_t)
+ * @param data data to compare with (const void *)
+ * @param size number of bytes (uint32_t)
+ * @return offset of the first byte that differs, size if none, EEPROM_CompareError on error (uint32_t)
+ */
+uint32_t EEPROM::compare(uint32_t address, const void *data, uint32_t size)
+{
+  int8_t buffer[EEPROM_ChecksumBuffer];
+  const int8_t *bytes = (const int8_t *)data;
+  uint32_t offset = 0, n, i;
+
+  // Check error
+  if (_errnum)
+    return (EEPROM_CompareError);
+
+  // Check address
+  if (!checkAddress(address) || !checkAddress(address + size - 1))
+  {
+    _errnum = EEPROM_OutOfRange;
+    return (EEPROM_CompareError);
+  }
+
+  while (offset < size)
+  {
+    n = (size - offset < EEPROM_ChecksumBuffer) ? size - offset : EEPROM_ChecksumBuffer;
+    read(address + offset, buffer, n);
+    if (_errnum)
+      return (EEPROM_CompareError);
+
+    for (i = 0; i < n; i++)
+    {
+      if (buffer[i] != bytes[offset + i])
+        return (offset + i);
+    }
+
+    offset += n;
+  }
+
+  return (size);
+}
+
+/**
+ * void copy(uint32_t src, uint32_t dst, uint32_t size)
+ *
+ * Copy a region inside the eeprom (memmove, overlapping regions allowed) through the member page buffer :
+ * the chunks are aligned on the destination pages, so each chunk is a single page program.
+ * A destination after an overlapping source is copied from the end
+ * @param src source address (uint32_t)
+ * @param dst destination address (uint32_t)
+ * @param size number of bytes to copy (uint32_t)
+ * @return none
+ */
+void EEPROM::copy(uint32_t src, uint32_t dst, uint32_t size)
+{
+  uint32_t count;
+  bool backward;
+
+  // Check error
+  if (_errnum || !size)
+    return;
+
+  // Check address, without wrapping for large sizes
+  if (!checkAddress(src) || size > _size - src || !checkAddress(dst) || size > _size - dst)
+  {
+    _errnum = EEPROM_OutOfRange;
+    return;
+  }
+
+  if (src == dst)
+    return;
+
+  backward = (dst > src && dst < src + size);
+
+  while (size && !_errnum)
+  {
+    if (backward)
+    {
+      // Last chunk : from the start of the last destination page
+      count = (dst + size) % _page_write;
+      if (count == 0 || count > size)
+        count = (size < _page_write) ? size : _page_write;
+
+      read(src + size - count, _buffer, count);
+      write(dst + size - count, _buffer, count);
+    }
+    else
+    {
+      count = _page_write - dst % _page_write;
+      if (count > size)
+        count = size;
+
+      read(src, _buffer, count);
+      write(dst, _buffer, count);
+
+      src += count;
+      dst += count;
+    }
+
+    size -= count;
+  }
+}
+
+/**
+ * void copyTo(EEPROM &target, uint32_t src, uint32_t dst, uint32_t size)
+ *
+ * Copy a region to another eeprom, on the same bus or not. The read while write
+ * mode of the target is enabled during the copy : a page program returns at once
+ * and the next chunk is read from this eeprom while the target is in its write
+ * cycle, the write cycle end is polled only before the next program. The chunks
+ * are aligned on the target pages, one page program per target page, and go
+ * through the member page buffer of this eeprom
+ * @param target destination eeprom, errors are reported by the eeprom where they occur (EEPROM&)
+ * @param src source address (uint32_t)
+ * @param dst destination address in the target (uint32_t)
+ * @param size number of bytes to copy (uint32_t)
+ * @return none
+ */
+void EEPROM::copyTo(EEPROM &target, uint32_t src, uint32_t dst, uint32_t size)
+{
+  uint32_t count;
+  bool read_while_write;
+
+  if (&target == this)
+  {
+    copy(src, dst, size);
+    return;
+  }
+
+  // Check error
+  if (_errnum || target._errnum || !size)
+    return;
+
+  // Check address, without wrapping for large sizes
+  if (!checkAddress(src) || size > _size - src)
+  {
+    _errnum = EEPROM_OutOfRange;
+    return;
+  }
+  if (!target.checkAddress(dst) || size > target._size - dst)
+  {
+    target._errnum = EEPROM_OutOfRange;
+    return;
+  }
+
+  read_while_write = target._read_while_write;
+  target._read_while_write = true;
+
+  while (size && !_errnum && !target._errnum)
+  {
+    count = target._page_write - dst % target._page_write;
+    if (count > size)
+      count = size;
+
+    // Read during the write cycle of the previous chunk
+    read(src, _buffer, count);
+    if (_errnum)
+      break;
+    target.write(dst, _buffer, count);
+
+    src += count;
+    dst += count;
+    size -= count;
+  }
+
+  target.setReadWhileWrite(read_while_write);
+}
+
+/**
+ * void setChangeTracking(bool enable, uint32_t store)
+ *
+ * Track the pages changed since the last backup (see backupTo) in a RAM bitmap, one bit per page.
+ * With a store, the bitmap is loaded from it (a blank store marks all the pages as changed) and
+ * the bitmap byte of a page is programmed in the store when the page is first changed, before
+ * the page itself, so that no change is lost across a reset. The store pages are not tracked
+ * @param enable true to enable, all the pages are then changed unless loaded from the store (bool)
+ * @param store address of a persistent copy of the bitmap on this eeprom, EEPROM_NoStore if none (uint32_t)
+ * @return none
+ */
+void EEPROM::setChangeTracking(bool enable, uint32_t store)
+{
+  uint32_t size;
+
+  free(_changed);
+  _changed = NULL;
+  _changed_store = EEPROM_NoStore;
+  _changed_size = 0;
+
+  // Check error
+  if (_errnum || !enable)
+    return;
+
+  size = (_size / _page_write + 7) / 8;
+
+  // Check address
+  if (store != EEPROM_NoStore && !checkAddress(store + size - 1))
+  {
+    _errnum = EEPROM_OutOfRange;
+    return;
+  }
+
+  _changed = (uint8_t *)malloc(size);
+  if (_changed == NULL)
+  {
+    _errnum = EEPROM_MallocError;
+    return;
+  }
+
+  memset(_changed, 0xFF, size);
+  if (store != EEPROM_NoStore)
+  {
+    read(store, (int8_t *)_changed, size);
+    if (_errnum)
+    {
+      free(_changed);
+      _changed = NULL;
+      return;
+    }
+  }
+
+  _changed_store = store;
+  _changed_size = size;
+}
+
+/**
+ * uint32_t getChangedPages(void)
+ *
+ * Get the number of pages changed since the last backup
+ * @param none
+ * @return number of pages (uint32_t)
+ */
+uint32_t EEPROM::getChangedPages(void)
+{
+  uint32_t count = 0, page;
+
+  if (_changed == NULL)
+    return (0);
+
+  for (page = 0; page < _size / _page_write; page++)
+  {
+    if (_changed[page / 8] & (1 << (page % 8)))
+      count++;
+  }
+
+  return (count);
+}
+
+/**
+ * uint32_t backupTo(EEPROM &target)
+ *
+ * Copy the pages changed since the last backup to the same addresses of another eeprom : each
+ * run of changed pages is one copyTo, the bitmap is then cleared and written to its store
+ * @param target backup eeprom, errors are reported by the eeprom where they occur (EEPROM&)
+ * @return number of bytes copied (uint32_t)
+ */
+uint32_t EEPROM::backupTo(EEPROM &target)
+{
+  uint32_t pages = _size / _page_write;
+  uint32_t moved = 0, first, page;
+
+  // Check error
+  if (_errnum || target._errnum)
+    return (0);
+
+  if (_changed == NULL || &target == this)
+  {
+    _errnum = EEPROM_ParamError;
+    return (0);
+  }
+
+  for (page = 0; page < pages && !_errnum && !target._errnum;)
+  {
+    if (!(_changed[page / 8] & (1 << (page % 8))))
+    {
+      page++;
+      continue;
+    }
+
+    // Run of changed pages
+    for (first = page; page < pages && (_changed[page / 8] & (1 << (page % 8))); page++)
+      ;
+
+    copyTo(target, first * _page_write, first * _page_write, (page - first) * _page_write);
+    if (_errnum || target._errnum)
+      break;
+
+    moved += (page - first) * _page_write;
+    for (; first < page; first++)
+      _changed[first / 8] &= ~(1 << (first % 8));
+  }
+
+  // Bitmap store, its own pages are not tracked
+  if (_changed_store != EEPROM_NoStore && moved)
+    write(_changed_store, (int8_t *)_changed, _changed_size);
+
+  return (moved);
+}
+
+/**
+ * void ready(void)
+ *
+ * Wait eeprom ready
+ * @param none
+ * @return none
+ */
+void EEPROM::ready(void)
+{
+  // Check error
+  if (_errnum)
+    return;
+
+  // No write cycle (FRAM) : always ready
+  if (_desc.write_time == 0)
+    return;
+
+  // Wait end of write, the probes are accounted in the bus budget
+  do
+  {
+    throttle(1, true);
+  } while (!busReady());
+
+  _busy = false;
+}
+
+/**
+ * bool isReady(void)
+ *
+ * Check without waiting if a write cycle left running (see setReadWhileWrite) has ended
+ * @param none
+ * @return true if the eeprom is ready, overwise false (bool)
+ */
+bool EEPROM::isReady(void)
+{
+  if (!_busy)
+    return (true);
+
+  if (!throttle(1, false) || !busReady())
+    return (false);
+
+  _busy = false;
+  return (true);
+}
+
+/**
+ * bool setReadWhileWrite(bool enable)
+ *
+ * Enable the reads during the write cycle : writes return without waiting the end of
+ * the write cycle, reads of the last programmed page are served from RAM and only the
+ * other accesses wait the end of the write cycle
+ * @param enable true to enable (bool)
+ * @return previous state, true if enabled (bool)
+ */
+bool EEPROM::setReadWhileWrite(bool enable)
+{
+  bool enabled = _read_while_write;
+
+  if (!enable)
+    waitWrite();
+
+  _read_while_write = enable;
+
+  return (enabled);
+}
+
+/**
+ * void setBusBudget(uint32_t rate, uint32_t burst, BudgetUnit unit)
+ *
+ * Limit the bus usage with a token bucket : the accesses wait for their tokens
+ * @param rate tokens per second, 0 for no limit (uint32_t)
+ * @param burst bucket size in tokens (uint32_t)
+ * @param unit token unit, bus bytes or transactions (BudgetUnit)
+ * @return none
+ */
+void EEPROM::setBusBudget(uint32_t rate, uint32_t burst, BudgetUnit unit)
+{
+  _budget_rate = rate;
+  _budget_burst = (uint64_t)burst * 1000000;
+  _budget_unit = unit;
+
+  // Start with a full bucket
+  _budget_tokens = _budget_burst;
+  _budget_time = us_ticker_read();
+}
+
+/**
+ * bool suspendBusBudget(bool suspend)
+ *
+ * Suspend the bus budget, the accesses no longer wait for tokens (emergency flush).
+ * On resume the bucket is refilled from the resume time, the bus used while
+ * suspended is not charged
+ * @param suspend true to suspend, false to resume (bool)
+ * @return previous state, true if the bus budget was suspended, to restore it after a nested suspend (bool)
+ */
+bool EEPROM::suspendBusBudget(bool suspend)
+{
+  bool suspended = _budget_suspended;
+
+  if (!suspend && _budget_suspended)
+    _budget_time = us_ticker_read();
+
+  _budget_suspended = suspend;
+
+  return (suspended);
+}
+
+/**
+ * uint32_t getTransferTime(uint32_t size)
+ *
+ * Get the bus time of a transaction (command, address and data)
+ * @param size number of data bytes (uint32_t)
+ * @return transfer time in us (uint32_t)
+ */
+uint32_t EEPROM::getTransferTime(uint32_t size)
+{
+  uint64_t clocks;
+
+  clocks = (uint64_t)(size + _desc.address_bytes + 1) * _bus_clocks;
+
+  return ((uint32_t)((clocks * 1000000 + _bus_frequency - 1) / _bus_frequency));
+}
+
+/**
+ * uint32_t getProgramTime(uint32_t size)
+ *
+ * Get the time of a page program, transfer and write cycle (tWR)
+ * @param size number of data bytes, inside one page (uint32_t)
+ * @return page program time in us (uint32_t)
+ */
+uint32_t EEPROM::getProgramTime(uint32_t size)
+{
+  return (getTransferTime(size) + (uint32_t)_desc.write_time * 1000);
+}
+
+/**
+ * uint32_t getSize(void)
+ *
+ * Get eeprom size in bytes
+ * @param  none
+ * @return size in bytes (uint32_t)
+ */
+uint32_t EEPROM::getSize(void)
 {
   return (_size);
 }
@@ -834,52 +1308,49 @@ uint32_t EEPROM::getSize(void)
  */
 const char *EEPROM::getName(void)
 {
-  uint8_t i = 0;
-
-  switch (_type)
-  {
-  case T24C01:
-    i = 0;
-    break;
-  case T24C02:
-    i = 1;
-    break;
-  case T24C04:
-    i = 2;
-    break;
-  case T24C08:
-    i = 3;
-    break;
-  case T24C16:
-    i = 4;
-    break;
-  case T24C32:
-    i = 5;
-    break;
-  case T24C64:
-    i = 6;
-    break;
-  case T24C128:
-    i = 7;
-    break;
-  case T24C256:
-    i = 8;
-    break;
-  case T24C512:
-    i = 9;
-    break;
-  case T24C1024:
-    i = 10;
-    break;
-  case T24C1025:
-    i = 11;
-    break;
-  case M24M02:
-    i = 12;
-    break;
-  }
-
-  return (_name[i]);
+  return (_desc.name);
+}
+
+/**
+ * uint16_t getPageSize(void)
+ *
+ * Get eeprom page size in bytes
+ * @param none
+ * @return page size in bytes, MAX_PAGE_SIZE if the device has no page limit (uint16_t)
+ */
+uint16_t EEPROM::getPageSize(void)
+{
+  return (_page_write);
+}
+
+/**
+ * uint8_t getWriteTime(void)
+ *
+ * Get eeprom write cycle time (tWR)
+ * @param none
+ * @return write cycle time in ms, 0 if the device has no write cycle (uint8_t)
+ */
+uint8_t EEPROM::getWriteTime(void)
+{
+  return (_desc.write_time);
+}
+
+/**
+ * const EEPROMDescriptor &getDescriptor(TypeEeprom type)
+ *
+ * Get the descriptor of a known device
+ * @param type eeprom type (TypeEeprom)
+ * @return device descriptor, of size 0 for an unknown type so that the constructors report EEPROM_ParamError (const EEPROMDescriptor&)
+ */
+const EEPROMDescriptor &EEPROM::getDescriptor(TypeEeprom type)
+{
+  size_t index = descriptorIndex(type);
+
+  // Unknown model, like a size cast to TypeEeprom
+  if (index == DESCRIPTOR_Count)
+    return (_unknown);
+
+  return (_descriptors[index]);
 }
 
 /**
@@ -903,63 +1374,309 @@ uint8_t EEPROM::getError(void)
  */
 bool EEPROM::checkAddress(uint32_t address)
 {
-  bool ret = true;
-
-  switch (_type)
-  {
-  case T24C01:
-    if (address >= T24C01)
-      ret = false;
-    break;
-  case T24C02:
-    if (address >= T24C02)
-      ret = false;
-    break;
-  case T24C04:
-    if (address >= T24C04)
-      ret = false;
-    break;
-  case T24C08:
-    if (address >= T24C08)
-      ret = false;
-    break;
-  case T24C16:
-    if (address >= T24C16)
-      ret = false;
-    break;
-  case T24C32:
-    if (address >= T24C32)
-      ret = false;
-    break;
-  case T24C64:
-    if (address >= T24C64)
-      ret = false;
-    break;
-  case T24C128:
-    if (address >= T24C128)
-      ret = false;
-    break;
-  case T24C256:
-    if (address >= T24C256)
-      ret = false;
-    break;
-  case T24C512:
-    if (address >= T24C512)
-      ret = false;
-    break;
-  case T24C1024:
-    if (address >= T24C1024)
-      ret = false;
-    break;
-  case T24C1025:
-    if (address >= T24C1025 - 1)
-      ret = false;
-    break;
-  case M24M02:
-    if (address >= M24M02 - 1)
-      ret = false;
-    break;
-  }
-
-  return (ret);
+  return (address < _size);
+}
+
+/**
+ * uint8_t deviceAddress(uint32_t &address)
+ *
+ * Compute the i2c device address of the page block holding address
+ * @param address data address, replaced by the word address inside the page block (uint32_t&)
+ * @return i2c device address (uint8_t)
+ */
+uint8_t EEPROM::deviceAddress(uint32_t &address)
+{
+  uint8_t page_block;
+
+  // Address bits above the word address select the page block
+  page_block = address >> (8 * _desc.address_bytes);
+  address &= (1UL << (8 * _desc.address_bytes)) - 1;
+
+  return (EEPROM_Address | _address | (page_block << _desc.block_shift));
+}
+
+/**
+ * void busRead(uint32_t address, int8_t *data, uint32_t size)
+ *
+ * Sequential read on the i2c bus, address range already checked
+ * @param address start address (uint32_t)
+ * @param data bytes array to read (int8_t *)
+ * @param size number of bytes to read (uint32_t)
+ * @return none
+ */
+void EEPROM::busRead(uint32_t address, int8_t *data, uint32_t size)
+{
+  uint8_t addr;
+  uint8_t cmd[2];
+  uint8_t len;
+  int ack;
+
+  // Device address and word address inside the page block
+  addr = deviceAddress(address);
+
+  // Depending on the EEPROM the address can either be on one or two bytes
+  len = _desc.address_bytes;
+
+  // Set the address part of cmd, in the case of the address on 2 bytes the MSB goes in the first element of cmd
+  for (auto l = 0; l < len; l++)
+    cmd[l] = (uint8_t)((address) >> (8 * (len - l - 1)));
+
+  // Write command then sequential read after a repeated start, the bus is held between them
+  _i2c->lock();
+  ack = _i2c->write((int)addr, (char *)cmd, len, true);
+  if (ack == 0)
+    ack = _i2c->read((int)addr, (char *)data, size);
+  _i2c->unlock();
+
+  if (ack != 0)
+    _errnum = EEPROM_I2cError;
+}
+
+/**
+ * void busReadCurrent(int8_t &data)
+ *
+ * Current address read on the i2c bus
+ * @param data byte to read (int8_t&)
+ * @return none
+ */
+void EEPROM::busReadCurrent(int8_t &data)
+{
+  uint8_t addr;
+  int ack;
+
+  // Device address
+  addr = EEPROM_Address | _address;
+
+  // Read data
+  ack = _i2c->read((int)addr, (char *)&data, sizeof(data));
+  if (ack != 0)
+  {
+    _errnum = EEPROM_I2cError;
+    return;
+  }
+}
+
+/**
+ * void busWrite(uint32_t address, int8_t *data, uint32_t size)
+ *
+ * Write inside one page on the i2c bus (any length on FRAM), address range already checked.
+ * The word address and the data are assembled in _frame and sent in a single transaction,
+ * atomic on a bus shared with other threads, MAX_PAGE_SIZE bytes at most per transaction.
+ * Does not wait the end of the write cycle
+ * @param address start address (uint32_t)
+ * @param data bytes array to write (int8_t *)
+ * @param size number of bytes to write (uint32_t)
+ * @return none
+ */
+void EEPROM::busWrite(uint32_t address, int8_t *data, uint32_t size)
+{
+  uint8_t addr;
+  uint32_t word_address;
+  uint32_t block_size;
+  uint32_t count;
+  int8_t *header;
+  uint8_t l;
+  int ack;
+
+  block_size = 1UL << (8 * _desc.address_bytes);
+  header = _frame + EEPROM_FrameHeader - _desc.address_bytes;
+
+  while (size)
+  {
+    // Stop at the end of the page block (the next one has another device address) or of the frame
+    count = block_size - address % block_size;
+    if (count > size)
+      count = size;
+    if (count > MAX_PAGE_SIZE)
+      count = MAX_PAGE_SIZE;
+
+    word_address = address;
+    addr = deviceAddress(word_address);
+
+    // MSB of the word address first
+    for (l = 0; l < _desc.address_bytes; l++)
+      header[l] = (int8_t)(word_address >> (8 * (_desc.address_bytes - l - 1)));
+    memcpy(_frame + EEPROM_FrameHeader, data, count);
+
+    ack = _i2c->write((int)addr, (char *)header, _desc.address_bytes + count);
+    if (ack != 0)
+    {
+      _errnum = EEPROM_I2cError;
+      return;
+    }
+
+    address += count;
+    data += count;
+    size -= count;
+  }
+}
+
+/**
+ * void waitWrite(void)
+ *
+ * Wait the end of a write cycle left running by endWrite
+ * @param none
+ * @return none
+ */
+void EEPROM::waitWrite(void)
+{
+  if (_busy)
+    ready();
+}
+
+/**
+ * void endWrite(uint32_t address, uint32_t size)
+ *
+ * End of a page program : wait the end of the write cycle, or keep the
+ * range of the programmed bytes, left in _frame by busWrite, for the reads
+ * during the write cycle
+ * @param address start address (uint32_t)
+ * @param size number of bytes programmed, inside one page (uint32_t)
+ * @return none
+ */
+void EEPROM::endWrite(uint32_t address, uint32_t size)
+{
+  if (!_read_while_write || _desc.write_time == 0)
+  {
+    ready();
+    return;
+  }
+
+  _pending_address = address;
+  _pending_size = size;
+  _busy = true;
+}
+
+/**
+ * bool readPending(uint32_t address, int8_t *data, uint32_t size)
+ *
+ * Read from the page in write cycle if it holds the whole range,
+ * overwise wait the end of the write cycle
+ * @param address start address (uint32_t)
+ * @param data bytes array to read (int8_t *)
+ * @param size number of bytes to read (uint32_t)
+ * @return true if the data has been read, overwise false (bool)
+ */
+bool EEPROM::readPending(uint32_t address, int8_t *data, uint32_t size)
+{
+  if (!_busy)
+    return (false);
+
+  if (address >= _pending_address && address + size <= _pending_address + _pending_size)
+  {
+    memcpy(data, _frame + EEPROM_FrameHeader + (address - _pending_address), size);
+    return (true);
+  }
+
+  waitWrite();
+  return (false);
+}
+
+/**
+ * void track(uint32_t address, uint32_t size)
+ *
+ * Mark the pages of a write as changed, the bitmap bytes that change are
+ * programmed in the store (see setChangeTracking)
+ * @param address start address (uint32_t)
+ * @param size number of bytes written (uint32_t)
+ * @return none
+ */
+void EEPROM::track(uint32_t address, uint32_t size)
+{
+  uint32_t page, last;
+  uint8_t bit;
+
+  if (_changed == NULL || !size)
+    return;
+
+  // Writes of the store itself
+  if (_changed_store != EEPROM_NoStore && address < _changed_store + _changed_size && _changed_store < address + size)
+    return;
+
+  last = (address + size - 1) / _page_write;
+  for (page = address / _page_write; page <= last; page++)
+  {
+    bit = 1 << (page % 8);
+    if (_changed[page / 8] & bit)
+      continue;
+
+    _changed[page / 8] |= bit;
+    if (_changed_store != EEPROM_NoStore)
+      write(_changed_store + page / 8, (int8_t)_changed[page / 8]);
+  }
+}
+
+/**
+ * bool busReady(void)
+ *
+ * Single ready probe on the i2c bus (the chip does not acknowledge during the write cycle)
+ * @param none
+ * @return true if the eeprom is ready, overwise false (bool)
+ */
+bool EEPROM::busReady(void)
+{
+  uint8_t addr;
+  uint8_t cmd[2];
+
+  // Device address
+  addr = EEPROM_Address | _address;
+
+  cmd[0] = 0;
+
+  return (_i2c->write((int)addr, (char *)cmd, 0) == 0);
+}
+
+/**
+ * bool throttle(uint32_t bytes, bool wait)
+ *
+ * Take the tokens of a bus transaction from the bus budget
+ * @param bytes bytes of the transaction on the bus (uint32_t)
+ * @param wait wait for the tokens if the bucket is short (bool)
+ * @return true if the tokens have been taken, overwise false (bool)
+ */
+bool EEPROM::throttle(uint32_t bytes, bool wait)
+{
+  uint64_t cost, delay;
+  uint32_t now, step;
+
+  if (_budget_rate == 0 || _budget_suspended)
+    return (true);
+
+  // Tokens are counted in millionths so that refills of less than one token are kept
+  cost = (_budget_unit == BudgetBytes) ? bytes : 1;
+  cost *= 1000000;
+
+  // A transaction larger than the bucket only needs a full bucket
+  if (cost > _budget_burst)
+    cost = _budget_burst;
+
+  now = us_ticker_read();
+  _budget_tokens += (uint64_t)(now - _budget_time) * _budget_rate;
+  _budget_time = now;
+  if (_budget_tokens > _budget_burst)
+    _budget_tokens = _budget_burst;
+
+  if (_budget_tokens < cost)
+  {
+    if (!wait)
+      return (false);
+
+    // Bounded steps : a large burst at a low rate waits longer than an int of us
+    delay = (cost - _budget_tokens + _budget_rate - 1) / _budget_rate;
+    while (delay)
+    {
+      step = (delay > EEPROM_BudgetWaitStep) ? EEPROM_BudgetWaitStep : (uint32_t)delay;
+      wait_us((int)step);
+      delay -= step;
+    }
+
+    now = us_ticker_read();
+    _budget_tokens += (uint64_t)(now - _budget_time) * _budget_rate;
+    _budget_time = now;
+    if (_budget_tokens < cost)
+      _budget_tokens = cost;
+  }
+
+  _budget_tokens -= cost;
+  return (true);
 }
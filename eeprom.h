@@ -362,10 +362,49 @@ int main()
 #define EEPROM_ParamError 0x03
 #define EEPROM_OutOfRange 0x04
 #define EEPROM_MallocError 0x05
+#define EEPROM_VerifyError 0x06
 
-#define EEPROM_MaxError 6
+#define EEPROM_MaxError 7
 
+// Largest page size of the devices used, sizes the member page buffers (bus frame, fill, copies).
+// Can be lowered at build time for small parts (e.g. 8 for 24C01/24C02)
+#ifndef MAX_PAGE_SIZE
 #define MAX_PAGE_SIZE 256
+#endif
+
+// Command and address bytes in front of the data in the bus frame of a page program
+#define EEPROM_FrameHeader 4
+
+// Result of compare() on error, never a valid offset
+#define EEPROM_CompareError 0xFFFFFFFF
+
+// Stack buffer of checksum() and compare(), one read per buffer.
+// Define EEPROM_HW_CRC to compute the CRC-32 with the MbedCRC driver (hardware CRC unit if the target has one)
+#ifndef EEPROM_ChecksumBuffer
+#define EEPROM_ChecksumBuffer 64
+#endif
+
+// No persistent store of the changed pages bitmap (see setChangeTracking)
+#define EEPROM_NoStore 0xFFFFFFFF
+
+// Longest single wait_us of the bus budget (us), longer token waits are made of several
+#define EEPROM_BudgetWaitStep 1000000
+
+/** Device descriptor, one per TypeEeprom or provided by the caller for other parts
+ */
+struct EEPROMDescriptor
+{
+  const char *name;            // Device name
+  uint32_t size;               // Size in bytes
+  uint16_t page_size;          // Page size in bytes, 0 if no page limit (FRAM)
+  uint8_t address_bytes;       // Word address length in bytes
+  uint8_t block_bits;          // Address bits above the word address (page blocks)
+  uint8_t block_shift;         // Position of the page block bits in the device address (i2c) or instruction (spi)
+  uint8_t chip_address_max;    // Highest chip address (i2c address pins)
+  uint8_t chip_address_shift;  // Position of the chip address in the device address (i2c)
+  uint8_t write_time;          // Write cycle time (tWR) in ms, 0 if no write cycle (FRAM)
+  bool spi;                    // SPI device
+};
 
 static std::string _ErrorMessageEEPROM[EEPROM_MaxError] = {
     "",
@@ -373,13 +412,16 @@ static std::string _ErrorMessageEEPROM[EEPROM_MaxError] = {
     "I2C error (nack)",
     "Invalid parameter",
     "Data address out of range",
-    "Memory allocation error"};
+    "Memory allocation error",
+    "Verify error (data read back differs)"};
 
 /** EEPROM Class
  */
 class EEPROM
 {
 public:
+  // Device models (see getDescriptor). The I2C EEPROM values of version 1.x are their
+  // sizes in bytes (T24C1025 excepted) and are kept, the other models are numbered from 1
   enum TypeEeprom
   {
     T24C01 = 128,
@@ -393,10 +435,41 @@ public:
     T24C256 = 32768,
     T24C512 = 65536,
     T24C1024 = 131072,
-    T24C1025 = 131073, 
-    M24M02 = 262144
+    T24C1025 = 131073,
+    M24M02 = 262144,
+    MB85RC04 = 1,
+    MB85RC16 = 2,
+    MB85RC64 = 3,
+    MB85RC128 = 4,
+    MB85RC256 = 5,
+    MB85RC512 = 6,
+    MB85RC1M = 7,
+    T25LC010 = 8,
+    T25LC020 = 9,
+    T25LC040 = 10,
+    T25LC080 = 11,
+    T25LC160 = 12,
+    T25LC320 = 13,
+    T25LC640 = 14,
+    T25LC128 = 15,
+    T25LC256 = 16,
+    T25LC512 = 17,
+    T25LC1024 = 18,
+    M24M01 = 19
   } Type;
 
+  enum BudgetUnit
+  {
+    BudgetBytes,
+    BudgetTransactions
+  };
+
+  enum ChecksumAlgo
+  {
+    ChecksumCRC32,
+    ChecksumFNV1a
+  };
+
   /**
    * Constructor, initialize the eeprom on i2c interface.
    * @param sda sda i2c pin (PinName)
@@ -407,6 +480,23 @@ public:
    */
   EEPROM(PinName sda, PinName scl, uint8_t address, TypeEeprom type);
 
+  /**
+   * Constructor for a device described by the caller, initialize the eeprom on i2c interface.
+   * @param sda sda i2c pin (PinName)
+   * @param scl scl i2c pin (PinName)
+   * @param address eeprom address, according to eeprom type (uint8_t)
+   * @param desc device descriptor, copied (const EEPROMDescriptor&)
+   * @return none
+   */
+  EEPROM(PinName sda, PinName scl, uint8_t address, const EEPROMDescriptor &desc);
+
+  /**
+   * Destructor
+   * @param none
+   * @return none
+   */
+  virtual ~EEPROM();
+
   /**
    * Random read byte
    * @param address start address (uint32_t)
@@ -506,7 +596,7 @@ public:
   void write(uint32_t address, void *data, uint32_t size);
 
   /**
-   * Write array of bytes (use the page mode)
+   * Write array of bytes (use the page mode, one transaction per MAX_PAGE_SIZE frame on FRAM)
    * @param address start address (uint32_t)
    * @param data bytes array to write (int8_t[])
    * @param size number of bytes to write (uint32_t)
@@ -514,6 +604,17 @@ public:
    */
   void write(uint32_t address, int8_t data[], uint32_t size);
 
+  /**
+   * Write a header followed by data (use the page mode), the header and the start of the data are one page program
+   * @param address start address (uint32_t)
+   * @param header bytes array to write first (int8_t[])
+   * @param header_size number of header bytes (uint32_t)
+   * @param data bytes array to write after the header (int8_t[])
+   * @param size number of data bytes (uint32_t)
+   * @return none
+   */
+  void write(uint32_t address, int8_t header[], uint32_t header_size, int8_t data[], uint32_t size);
+
   /**
    * Wait eeprom ready
    * @param none
@@ -521,6 +622,52 @@ public:
    */
   void ready(void);
 
+  /**
+   * Check without waiting if a write cycle left running (see setReadWhileWrite) has ended
+   * @param none
+   * @return true if the eeprom is ready, overwise false (bool)
+   */
+  bool isReady(void);
+
+  /**
+   * Enable the reads during the write cycle : writes return without waiting the end of
+   * the write cycle, reads of the last programmed page are served from RAM and only the
+   * other accesses wait the end of the write cycle
+   * @param enable true to enable (bool)
+   * @return previous state, true if enabled (bool)
+   */
+  bool setReadWhileWrite(bool enable);
+
+  /**
+   * Limit the bus usage with a token bucket : the accesses wait for their tokens
+   * @param rate tokens per second, 0 for no limit (uint32_t)
+   * @param burst bucket size in tokens (uint32_t)
+   * @param unit token unit, bus bytes or transactions (BudgetUnit)
+   * @return none
+   */
+  void setBusBudget(uint32_t rate, uint32_t burst, BudgetUnit unit = BudgetBytes);
+
+  /**
+   * Suspend the bus budget, the accesses no longer wait for tokens (emergency flush)
+   * @param suspend true to suspend, false to resume (bool)
+   * @return previous state, true if the bus budget was suspended, to restore it after a nested suspend (bool)
+   */
+  bool suspendBusBudget(bool suspend);
+
+  /**
+   * Get the bus time of a transaction (command, address and data)
+   * @param size number of data bytes (uint32_t)
+   * @return transfer time in us (uint32_t)
+   */
+  uint32_t getTransferTime(uint32_t size);
+
+  /**
+   * Get the time of a page program, transfer and write cycle (tWR)
+   * @param size number of data bytes, inside one page (uint32_t)
+   * @return page program time in us (uint32_t)
+   */
+  uint32_t getProgramTime(uint32_t size);
+
   /**
    * Get eeprom size in bytes
    * @param none
@@ -535,6 +682,36 @@ public:
    */
   const char *getName(void);
 
+  /**
+   * Get eeprom page size in bytes
+   * @param none
+   * @return page size in bytes, MAX_PAGE_SIZE if the device has no page limit (uint16_t)
+   */
+  uint16_t getPageSize(void);
+
+  /**
+   * Get eeprom write cycle time (tWR)
+   * @param none
+   * @return write cycle time in ms, 0 if the device has no write cycle (uint8_t)
+   */
+  uint8_t getWriteTime(void);
+
+  /**
+   * Get the descriptor of a known device
+   * @param type eeprom type (TypeEeprom)
+   * @return device descriptor, of size 0 for an unknown type so that the constructors report EEPROM_ParamError (const EEPROMDescriptor&)
+   */
+  static const EEPROMDescriptor &getDescriptor(TypeEeprom type);
+
+  /**
+   * Fill a range with a byte value (use the page mode)
+   * @param address start address (uint32_t)
+   * @param data byte value (int8_t)
+   * @param size number of bytes to fill (uint32_t)
+   * @return none
+   */
+  void fill(uint32_t address, int8_t data, uint32_t size);
+
   /**
    * Clear eeprom (write with 0)
    * @param  none
@@ -542,6 +719,65 @@ public:
    */
   void clear(void);
 
+  /**
+   * Checksum of a region, streamed through a EEPROM_ChecksumBuffer bytes buffer
+   * @param address start address (uint32_t)
+   * @param size number of bytes (uint32_t)
+   * @param algo CRC-32 (IEEE 802.3) or FNV-1a 32 bits hash (ChecksumAlgo)
+   * @return checksum (uint32_t)
+   */
+  uint32_t checksum(uint32_t address, uint32_t size, ChecksumAlgo algo = ChecksumCRC32);
+
+  /**
+   * Compare a region with a buffer, streamed through a EEPROM_ChecksumBuffer bytes buffer, stops at the first difference
+   * @param address start address (uint32_t)
+   * @param data data to compare with (const void *)
+   * @param size number of bytes (uint32_t)
+   * @return offset of the first byte that differs, size if none, EEPROM_CompareError on error (uint32_t)
+   */
+  uint32_t compare(uint32_t address, const void *data, uint32_t size);
+
+  /**
+   * Copy a region inside the eeprom (memmove, overlapping regions allowed) through the member page buffer, one page program per destination page
+   * @param src source address (uint32_t)
+   * @param dst destination address (uint32_t)
+   * @param size number of bytes to copy (uint32_t)
+   * @return none
+   */
+  void copy(uint32_t src, uint32_t dst, uint32_t size);
+
+  /**
+   * Copy a region to another eeprom, the next page is read while the target is in its write cycle
+   * @param target destination eeprom, errors are reported by the eeprom where they occur (EEPROM&)
+   * @param src source address (uint32_t)
+   * @param dst destination address in the target (uint32_t)
+   * @param size number of bytes to copy (uint32_t)
+   * @return none
+   */
+  void copyTo(EEPROM &target, uint32_t src, uint32_t dst, uint32_t size);
+
+  /**
+   * Track the pages changed since the last backup (see backupTo) in a RAM bitmap, one bit per page
+   * @param enable true to enable, all the pages are then changed unless loaded from the store (bool)
+   * @param store address of a persistent copy of the bitmap on this eeprom, EEPROM_NoStore if none (uint32_t)
+   * @return none
+   */
+  void setChangeTracking(bool enable, uint32_t store = EEPROM_NoStore);
+
+  /**
+   * Get the number of pages changed since the last backup
+   * @param none
+   * @return number of pages (uint32_t)
+   */
+  uint32_t getChangedPages(void);
+
+  /**
+   * Copy the pages changed since the last backup to the same addresses of another eeprom
+   * @param target backup eeprom, errors are reported by the eeprom where they occur (EEPROM&)
+   * @return number of bytes copied (uint32_t)
+   */
+  uint32_t backupTo(EEPROM &target);
+
   /**
    * Get the current error number (EEPROM_NoError if no error)
    * @param  none
@@ -560,16 +796,82 @@ public:
   }
 
   //---------- local variables ----------
-private:
-  I2C _i2c;                            // Local i2c communication interface instance
-  int _address;                        // Local i2c address
+protected:
+  /**
+   * Constructor for the other bus backends (see EEPROMSPI)
+   * @param desc device descriptor, copied (const EEPROMDescriptor&)
+   * @return none
+   */
+  EEPROM(const EEPROMDescriptor &desc);
+
+  /**
+   * Sequential read, address range already checked
+   * @param address start address (uint32_t)
+   * @param data bytes array to read (int8_t *)
+   * @param size number of bytes to read (uint32_t)
+   * @return none
+   */
+  virtual void busRead(uint32_t address, int8_t *data, uint32_t size);
+
+  /**
+   * Current address read byte
+   * @param data byte to read (int8_t&)
+   * @return none
+   */
+  virtual void busReadCurrent(int8_t &data);
+
+  /**
+   * Write inside one page (any length on FRAM), address range already checked.
+   * The data is sent from _frame, in transactions of MAX_PAGE_SIZE bytes at most.
+   * Does not wait the end of the write cycle (see ready)
+   * @param address start address (uint32_t)
+   * @param data bytes array to write (int8_t *)
+   * @param size number of bytes to write (uint32_t)
+   * @return none
+   */
+  virtual void busWrite(uint32_t address, int8_t *data, uint32_t size);
+
+  /**
+   * Single ready probe, true once the write cycle has ended
+   * @param none
+   * @return true if the eeprom is ready, overwise false (bool)
+   */
+  virtual bool busReady(void);
+
   uint8_t _errnum;                     // Error number
-  TypeEeprom _type;                    // EEPROM type
-  uint16_t _page_write;                 // Page size
-  uint8_t _page_block_number;          // Number of internally addressable page blocks
+  EEPROMDescriptor _desc;              // Device descriptor
+  uint16_t _page_write;                 // Page size (MAX_PAGE_SIZE if no page limit)
   uint32_t _size;                      // Size in bytes
+  uint32_t _bus_frequency;             // Bus clock in Hz
+  uint8_t _bus_clocks;                 // Bus clocks per byte
   bool checkAddress(uint32_t address); // Check address range
-  static const char *const _name[];    // eeprom name
+  void waitWrite(void);                // Wait the end of a write cycle left running
+  bool throttle(uint32_t bytes, bool wait); // Take the tokens of a bus transaction
+  int8_t _frame[EEPROM_FrameHeader + MAX_PAGE_SIZE]; // Bus frame of the last page program : command and address (right aligned), then the bytes in write cycle
+
+private:
+  EEPROM(const EEPROM &);              // Not copyable, owns the i2c interface
+  EEPROM &operator=(const EEPROM &);
+  I2C *_i2c;                           // Local i2c communication interface instance
+  int _address;                        // Local i2c address
+  bool _read_while_write;              // Writes return during the write cycle
+  bool _busy;                          // Write cycle may be running
+  int8_t _buffer[MAX_PAGE_SIZE];       // Page buffer of fill(), copy(), copyTo() and of the header write
+  uint32_t _pending_address;           // Address of the bytes in write cycle
+  uint16_t _pending_size;              // Number of bytes in write cycle
+  uint32_t _budget_rate;               // Bus budget in tokens per second (0 if no limit)
+  uint64_t _budget_burst;              // Bucket size (millionths of token)
+  uint64_t _budget_tokens;             // Tokens in the bucket (millionths of token)
+  uint32_t _budget_time;               // Last refill (us)
+  BudgetUnit _budget_unit;             // Token unit
+  bool _budget_suspended;              // Bus budget suspended
+  uint8_t *_changed;                   // Changed pages bitmap, NULL if no tracking
+  uint32_t _changed_store;             // Persistent copy of the bitmap, EEPROM_NoStore if none
+  uint32_t _changed_size;              // Bitmap size in bytes
+  void endWrite(uint32_t address, uint32_t size); // Wait end of write or keep the page range
+  bool readPending(uint32_t address, int8_t *data, uint32_t size); // Read from the page in write cycle
+  void track(uint32_t address, uint32_t size); // Mark the pages of a write as changed
+  uint8_t deviceAddress(uint32_t &address); // Device address of the page block, address becomes the word address
   //-------------------------------------
 };
 #endif
@@ -0,0 +1,308 @@
+#ifndef __EEPROM_LAYOUT__H_
+#define __EEPROM_LAYOUT__H_
+
+/***********************************************************
+Compile time layout of the fields stored on an EEPROM.
+
+The fields are declared in a constexpr table instead of address
+defines, layoutAddress() gives their address at compile time :
+  - a field smaller than a page never straddles a page boundary, it
+    moves to the next page when it does not fit in the current one
+  - a field of a page or more starts on a page boundary
+  - the fields are grouped by update frequency (LAYOUT_Hot first), each
+    group starting on a new page, so a frequent update never programs
+    a page holding rarely updated data
+  - a field with a fixed address (legacy layout) is left in place, the
+    other fields are placed around it
+
+EEPROM_LAYOUT_CHECK() stops the build if the layout overflows the
+device, if two fields overlap or if a field with a fixed address
+straddles a page. layoutCheck() checks at run time that the device
+matches the page and device sizes used to plan the layout.
+
+Everything is C++11 constexpr and costs nothing at run time. Placing a
+field walks the table once per group and checks each candidate offset
+against the fixed fields : an address or EEPROM_LAYOUT_CHECK() costs
+about n*n*(f+1) compile time steps for n fields with f fixed addresses,
+with a recursion depth of about n per group.
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom.h"
+#include "eeprom_layout.h"
+
+enum Field
+{
+  BootCount,
+  Setpoint,
+  Calibration,
+  SerialNumber,
+  FieldCount
+};
+
+constexpr LayoutField fields[FieldCount] = {
+    {"boot count", 4, LAYOUT_Hot, LAYOUT_Auto},
+    {"setpoint", 4, LAYOUT_Warm, LAYOUT_Auto},
+    {"calibration", 100, LAYOUT_Cold, LAYOUT_Auto},
+    {"serial number", 16, LAYOUT_Cold, 0x1FF0}};    // Fixed by the production tester
+
+#define FIELD_PAGE 32
+#define FIELD_ADDR(f) layoutAddress(fields, f, FIELD_PAGE, 0)
+EEPROM_LAYOUT_CHECK(fields, FIELD_PAGE, 8192, 0);
+
+EEPROM ep(p9,p10,0,EEPROM::T24C64);
+
+int main()
+{
+  int32_t boots;
+
+  if(!layoutCheck(ep, FIELD_PAGE, layoutEnd(fields, FIELD_PAGE, 0)))
+    error("layout planned for another eeprom\n");
+
+  ep.read(FIELD_ADDR(BootCount),boots);
+  ep.write(FIELD_ADDR(BootCount),boots + 1);
+
+  return(0);
+}
+*/
+
+// Defines
+#define LAYOUT_Auto 0xFFFFFFFF
+#define LAYOUT_Hot 0
+#define LAYOUT_Warm 1
+#define LAYOUT_Cold 2
+
+// Build time checks of a layout table
+#define EEPROM_LAYOUT_CHECK(fields, page, size, base) \
+  static_assert(layoutEnd(fields, page, base) <= (size), "EEPROM layout overflows the device"); \
+  static_assert(!layoutCollides(fields, page, base), "EEPROM layout has overlapping fields"); \
+  static_assert(!layoutStraddles(fields, page, base), "EEPROM layout has a field straddling a page boundary")
+
+/** Field of an eeprom layout
+ */
+struct LayoutField
+{
+  const char *name;            // Field name
+  uint32_t size;               // Size in bytes
+  uint8_t group;               // Update frequency, LAYOUT_Hot first
+  uint32_t address;            // Fixed address, LAYOUT_Auto to let the planner place the field
+};
+
+/**
+ * Offset of a field placed at offset or after, not straddling a page
+ * @param offset first free offset (uint32_t)
+ * @param size field size in bytes (uint32_t)
+ * @param page page size in bytes (uint32_t)
+ * @return field offset (uint32_t)
+ */
+constexpr uint32_t layoutAlign(uint32_t offset, uint32_t size, uint32_t page)
+{
+  return ((size >= page) ? (offset + page - 1) / page * page
+          : (offset % page + size > page) ? (offset / page + 1) * page
+          : offset);
+}
+
+/**
+ * Larger of two values
+ * @param a first value (uint32_t)
+ * @param b second value (uint32_t)
+ * @return larger value (uint32_t)
+ */
+constexpr uint32_t layoutMax(uint32_t a, uint32_t b)
+{
+  return ((a > b) ? a : b);
+}
+
+/**
+ * Highest group of the fields placed by the planner
+ * @param fields layout table (const LayoutField[])
+ * @param i first field (size_t)
+ * @return group (uint8_t)
+ */
+template <size_t N>
+constexpr uint8_t layoutMaxGroup(const LayoutField (&fields)[N], size_t i = 0)
+{
+  return ((i == N) ? 0
+          : layoutMax((fields[i].address == LAYOUT_Auto) ? fields[i].group : 0, layoutMaxGroup(fields, i + 1)));
+}
+
+/**
+ * End of the highest field with a fixed address
+ * @param fields layout table (const LayoutField[])
+ * @param i first field (size_t)
+ * @return end address, 0 if none (uint32_t)
+ */
+template <size_t N>
+constexpr uint32_t layoutFixedEnd(const LayoutField (&fields)[N], size_t i = 0)
+{
+  return ((i == N) ? 0
+          : layoutMax((fields[i].address != LAYOUT_Auto) ? fields[i].address + fields[i].size : 0, layoutFixedEnd(fields, i + 1)));
+}
+
+/**
+ * End of the first field with a fixed address overlapping a range
+ * @param fields layout table (const LayoutField[])
+ * @param start range start (uint32_t)
+ * @param size range size in bytes (uint32_t)
+ * @param i first field (size_t)
+ * @return end address of the field, 0 if none (uint32_t)
+ */
+template <size_t N>
+constexpr uint32_t layoutFixedHit(const LayoutField (&fields)[N], uint32_t start, uint32_t size, size_t i = 0)
+{
+  return ((i == N) ? 0
+          : (fields[i].address != LAYOUT_Auto && fields[i].size && size &&
+             fields[i].address < start + size && start < fields[i].address + fields[i].size) ? fields[i].address + fields[i].size
+          : layoutFixedHit(fields, start, size, i + 1));
+}
+
+template <size_t N>
+constexpr uint32_t layoutFit(const LayoutField (&fields)[N], uint32_t offset, uint32_t size, uint32_t page);
+
+/**
+ * Keep a candidate offset or retry after the fixed field it overlaps
+ * @param fields layout table (const LayoutField[])
+ * @param offset candidate offset (uint32_t)
+ * @param size field size in bytes (uint32_t)
+ * @param page page size in bytes (uint32_t)
+ * @param hit end of the fixed field overlapping the candidate, 0 if none (uint32_t)
+ * @return field offset (uint32_t)
+ */
+template <size_t N>
+constexpr uint32_t layoutFitAt(const LayoutField (&fields)[N], uint32_t offset, uint32_t size, uint32_t page, uint32_t hit)
+{
+  return (hit ? layoutFit(fields, hit, size, page) : offset);
+}
+
+/**
+ * Offset of a field placed at offset or after, not straddling a page and not overlapping
+ * a field with a fixed address
+ * @param fields layout table (const LayoutField[])
+ * @param offset first free offset (uint32_t)
+ * @param size field size in bytes (uint32_t)
+ * @param page page size in bytes (uint32_t)
+ * @return field offset (uint32_t)
+ */
+template <size_t N>
+constexpr uint32_t layoutFit(const LayoutField (&fields)[N], uint32_t offset, uint32_t size, uint32_t page)
+{
+  return (layoutFitAt(fields, layoutAlign(offset, size, page), size, page,
+                      layoutFixedHit(fields, layoutAlign(offset, size, page), size)));
+}
+
+/**
+ * Walk the fields placed by the planner, group by group, up to a field
+ * @param fields layout table (const LayoutField[])
+ * @param page page size in bytes (uint32_t)
+ * @param target field to place, N for the end of the placed fields (size_t)
+ * @param last highest group (uint8_t)
+ * @param group current group (uint8_t)
+ * @param i current field (size_t)
+ * @param offset first free offset (uint32_t)
+ * @param fresh group start, the next field goes to a new page (bool)
+ * @return field address, end of the placed fields for N, LAYOUT_Auto if not found (uint32_t)
+ */
+template <size_t N>
+constexpr uint32_t layoutPlace(const LayoutField (&fields)[N], uint32_t page, size_t target, uint8_t last, uint8_t group, size_t i, uint32_t offset, bool fresh)
+{
+  return ((group > last) ? ((target == N) ? offset : LAYOUT_Auto)
+          : (i == N) ? layoutPlace(fields, page, target, last, group + 1, 0, offset, true)
+          : (fields[i].address != LAYOUT_Auto || fields[i].group != group) ? layoutPlace(fields, page, target, last, group, i + 1, offset, fresh)
+          : (i == target) ? layoutFit(fields, fresh ? (offset + page - 1) / page * page : offset, fields[i].size, page)
+          : layoutPlace(fields, page, target, last, group, i + 1,
+                        layoutFit(fields, fresh ? (offset + page - 1) / page * page : offset, fields[i].size, page) + fields[i].size, false));
+}
+
+/**
+ * Address of a field
+ * @param fields layout table (const LayoutField[])
+ * @param index field index (size_t)
+ * @param page page size in bytes, the planned layout fits any device with a multiple of this page size (uint32_t)
+ * @param base start address of the layout (uint32_t)
+ * @return field address (uint32_t)
+ */
+template <size_t N>
+constexpr uint32_t layoutAddress(const LayoutField (&fields)[N], size_t index, uint32_t page, uint32_t base)
+{
+  return ((fields[index].address != LAYOUT_Auto) ? fields[index].address
+          : layoutPlace(fields, page, index, layoutMaxGroup(fields), 0, 0, base, false));
+}
+
+/**
+ * End address of the layout, after its last field
+ * @param fields layout table (const LayoutField[])
+ * @param page page size in bytes (uint32_t)
+ * @param base start address of the layout (uint32_t)
+ * @return end address (uint32_t)
+ */
+template <size_t N>
+constexpr uint32_t layoutEnd(const LayoutField (&fields)[N], uint32_t page, uint32_t base)
+{
+  return (layoutMax(layoutPlace(fields, page, N, layoutMaxGroup(fields), 0, 0, base, false), layoutFixedEnd(fields)));
+}
+
+/**
+ * Check if a field smaller than a page straddles a page boundary (fixed addresses, the
+ * planner never places a field across a boundary)
+ * @param fields layout table (const LayoutField[])
+ * @param page page size in bytes (uint32_t)
+ * @param base start address of the layout (uint32_t)
+ * @param i first field (size_t)
+ * @return true if a field straddles a page boundary, overwise false (bool)
+ */
+template <size_t N>
+constexpr bool layoutStraddles(const LayoutField (&fields)[N], uint32_t page, uint32_t base, size_t i = 0)
+{
+  return ((i < N) && ((fields[i].address != LAYOUT_Auto && fields[i].size <= page && fields[i].address % page + fields[i].size > page) ||
+                      layoutStraddles(fields, page, base, i + 1)));
+}
+
+/**
+ * Check if a field with a fixed address overlaps one of the next fixed fields
+ * @param fields layout table (const LayoutField[])
+ * @param i field (size_t)
+ * @param j first next field (size_t)
+ * @return true if the fields overlap, overwise false (bool)
+ */
+template <size_t N>
+constexpr bool layoutOverlaps(const LayoutField (&fields)[N], size_t i, size_t j)
+{
+  return ((j < N) && ((fields[j].address != LAYOUT_Auto && fields[i].size && fields[j].size &&
+                       fields[i].address < fields[j].address + fields[j].size &&
+                       fields[j].address < fields[i].address + fields[i].size) ||
+                      layoutOverlaps(fields, i, j + 1)));
+}
+
+/**
+ * Check if two fields overlap : the planner places the other fields around the fixed
+ * ones, so only the fields with a fixed address can overlap
+ * @param fields layout table (const LayoutField[])
+ * @param page page size in bytes (uint32_t)
+ * @param base start address of the layout (uint32_t)
+ * @param i first field (size_t)
+ * @return true if two fields overlap, overwise false (bool)
+ */
+template <size_t N>
+constexpr bool layoutCollides(const LayoutField (&fields)[N], uint32_t page, uint32_t base, size_t i = 0)
+{
+  return ((i < N) && ((fields[i].address != LAYOUT_Auto && layoutOverlaps(fields, i, i + 1)) ||
+                      layoutCollides(fields, page, base, i + 1)));
+}
+
+/**
+ * Check at run time that an eeprom matches a planned layout
+ * @param ep eeprom (EEPROM&)
+ * @param page page size used to plan the layout (uint32_t)
+ * @param end end address of the layout (uint32_t)
+ * @return true if the eeprom page size is a multiple of page and the layout fits, overwise false (bool)
+ */
+inline bool layoutCheck(EEPROM &ep, uint32_t page, uint32_t end)
+{
+  return (ep.getPageSize() % page == 0 && end <= ep.getSize());
+}
+#endif
@@ -0,0 +1,189 @@
+/***********************************************************
+Full RAM mirror of a small EEPROM.
+************************************************************/
+#include "eeprom_mirror.h"
+
+/**
+ * EEPROMMirror(EEPROM &ep)
+ *
+ * Constructor, no access is done to the eeprom (see load)
+ * @param ep mirrored eeprom, up to MIRROR_MaxSize bytes, pages of MIRROR_MinPage bytes or more (EEPROM&)
+ * @return none
+ */
+EEPROMMirror::EEPROMMirror(EEPROM &ep) : _ep(ep)
+{
+  _errnum = EEPROM_NoError;
+  _size = ep.getSize();
+  _page_size = ep.getPageSize();
+  _loaded = false;
+  memset(_dirty, 0, sizeof(_dirty));
+
+  // The dirty page bitmap holds MIRROR_MaxSize / MIRROR_MinPage pages
+  if (_size > MIRROR_MaxSize || _page_size < MIRROR_MinPage)
+    _errnum = EEPROM_ParamError;
+}
+
+/**
+ * void load(void)
+ *
+ * Read the whole eeprom into RAM, one block read per MIRROR_LoadBlock bytes.
+ * The dirty pages are dropped
+ * @param none
+ * @return none
+ */
+void EEPROMMirror::load(void)
+{
+  uint32_t address, n;
+
+  // Check error
+  if (_errnum)
+    return;
+
+  for (address = 0; address < _size; address += n)
+  {
+    n = (_size - address < MIRROR_LoadBlock) ? _size - address : MIRROR_LoadBlock;
+    _ep.read(address, (int8_t *)_data + address, n);
+    if (_ep.getError() != EEPROM_NoError)
+    {
+      _errnum = _ep.getError();
+      return;
+    }
+  }
+
+  memset(_dirty, 0, sizeof(_dirty));
+  _loaded = true;
+}
+
+/**
+ * void read(uint32_t address, void *data, uint32_t size)
+ *
+ * Read from the RAM mirror
+ * @param address start address (uint32_t)
+ * @param data buffer for the data (void *)
+ * @param size number of bytes to read (uint32_t)
+ * @return none
+ */
+void EEPROMMirror::read(uint32_t address, void *data, uint32_t size)
+{
+  if (!check(address, size))
+    return;
+
+  memcpy(data, _data + address, size);
+}
+
+/**
+ * void write(uint32_t address, const void *data, uint32_t size)
+ *
+ * Write to the RAM mirror, the pages holding changed bytes are marked dirty
+ * @param address start address (uint32_t)
+ * @param data data to write (const void *)
+ * @param size number of bytes to write (uint32_t)
+ * @return none
+ */
+void EEPROMMirror::write(uint32_t address, const void *data, uint32_t size)
+{
+  const uint8_t *in = (const uint8_t *)data;
+  uint32_t i, page;
+
+  if (!check(address, size))
+    return;
+
+  for (i = 0; i < size; i++)
+  {
+    if (_data[address + i] != in[i])
+    {
+      _data[address + i] = in[i];
+      page = (address + i) / _page_size;
+      _dirty[page / 8] |= 1 << (page % 8);
+    }
+  }
+}
+
+/**
+ * void sync(void)
+ *
+ * Program the dirty pages, each one as a whole aligned page
+ * @param none
+ * @return none
+ */
+void EEPROMMirror::sync(void)
+{
+  uint32_t page;
+
+  // Check error
+  if (_errnum)
+    return;
+
+  for (page = 0; page * _page_size < _size; page++)
+  {
+    if (!(_dirty[page / 8] & (1 << (page % 8))))
+      continue;
+
+    _ep.write(page * _page_size, (int8_t *)_data + page * _page_size, _page_size);
+    if (_ep.getError() != EEPROM_NoError)
+    {
+      _errnum = _ep.getError();
+      return;
+    }
+    _dirty[page / 8] &= ~(1 << (page % 8));
+  }
+}
+
+/**
+ * uint16_t getDirtyPages(void)
+ *
+ * Get the number of dirty pages
+ * @param none
+ * @return number of pages (uint16_t)
+ */
+uint16_t EEPROMMirror::getDirtyPages(void)
+{
+  uint16_t count = 0;
+  uint32_t page;
+
+  for (page = 0; page * _page_size < _size; page++)
+  {
+    if (_dirty[page / 8] & (1 << (page % 8)))
+      count++;
+  }
+
+  return (count);
+}
+
+/**
+ * uint8_t getError(void)
+ *
+ * Get the current error number (EEPROM_NoError if no error)
+ * @param none
+ * @return none
+ */
+uint8_t EEPROMMirror::getError(void)
+{
+  return (_errnum);
+}
+
+/**
+ * bool check(uint32_t address, uint32_t size)
+ *
+ * Check that the mirror is loaded and the range inside the eeprom
+ * @param address start address (uint32_t)
+ * @param size number of bytes (uint32_t)
+ * @return true if the access can be done, overwise false (bool)
+ */
+bool EEPROMMirror::check(uint32_t address, uint32_t size)
+{
+  // Check error
+  if (_errnum)
+    return (false);
+
+  if (!_loaded)
+    load();
+
+  if (address >= _size || size > _size - address)
+  {
+    _errnum = EEPROM_OutOfRange;
+    return (false);
+  }
+
+  return (!_errnum);
+}
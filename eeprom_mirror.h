@@ -0,0 +1,122 @@
+#ifndef __EEPROM_MIRROR__H_
+#define __EEPROM_MIRROR__H_
+
+/***********************************************************
+Full RAM mirror of a small EEPROM.
+
+For parts up to MIRROR_MaxSize bytes (24C16 by default) the whole
+device is read into RAM by load(), one block read per 256 bytes. Reads
+are then served from RAM with no bus access, writes update RAM and mark
+the pages holding changed bytes in a dirty page bitmap, and sync()
+programs the dirty pages only, each one as a whole aligned page from
+RAM (one page program per page, no read back).
+
+Writes between two sync() are lost on reset.
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom.h"
+#include "eeprom_mirror.h"
+
+EEPROM ep(p9,p10,0,EEPROM::T24C16);
+EEPROMMirror config(ep);
+
+int main()
+{
+  int32_t baudrate;
+
+  config.load();
+  config.read(0x10,&baudrate,sizeof(baudrate));
+  baudrate = 115200;
+  config.write(0x10,&baudrate,sizeof(baudrate));
+  config.sync();
+
+  return(0);
+}
+*/
+
+// Defines
+// Largest mirrored device, sizes the RAM copy
+#ifndef MIRROR_MaxSize
+#define MIRROR_MaxSize 2048
+#endif
+#define MIRROR_LoadBlock 256
+// Smallest page size accepted, sizes the dirty page bitmap
+#define MIRROR_MinPage 8
+
+/** EEPROMMirror Class
+ */
+class EEPROMMirror
+{
+public:
+  /**
+   * Constructor, no access is done to the eeprom (see load)
+   * @param ep mirrored eeprom, up to MIRROR_MaxSize bytes, pages of MIRROR_MinPage bytes or more (EEPROM&)
+   * @return none
+   */
+  EEPROMMirror(EEPROM &ep);
+
+  /**
+   * Read the whole eeprom into RAM, the dirty pages are dropped
+   * @param none
+   * @return none
+   */
+  void load(void);
+
+  /**
+   * Read from the RAM mirror
+   * @param address start address (uint32_t)
+   * @param data buffer for the data (void *)
+   * @param size number of bytes to read (uint32_t)
+   * @return none
+   */
+  void read(uint32_t address, void *data, uint32_t size);
+
+  /**
+   * Write to the RAM mirror, the pages holding changed bytes are marked dirty
+   * @param address start address (uint32_t)
+   * @param data data to write (const void *)
+   * @param size number of bytes to write (uint32_t)
+   * @return none
+   */
+  void write(uint32_t address, const void *data, uint32_t size);
+
+  /**
+   * Program the dirty pages
+   * @param none
+   * @return none
+   */
+  void sync(void);
+
+  /**
+   * Get the number of dirty pages
+   * @param none
+   * @return number of pages (uint16_t)
+   */
+  uint16_t getDirtyPages(void);
+
+  /**
+   * Get the current error number (EEPROM_NoError if no error)
+   * @param  none
+   * @return none
+   */
+  uint8_t getError(void);
+
+  //---------- local variables ----------
+private:
+  EEPROM &_ep;                                      // Mirrored eeprom
+  uint32_t _size;                                   // Eeprom size in bytes
+  uint16_t _page_size;                              // Page size in bytes
+  uint8_t _errnum;                                  // Error number
+  bool _loaded;                                     // load done
+  uint8_t _data[MIRROR_MaxSize];                    // RAM copy
+  uint8_t _dirty[(MIRROR_MaxSize / MIRROR_MinPage + 7) / 8]; // Dirty page bitmap, one bit per page
+  bool check(uint32_t address, uint32_t size);      // Check the mirror and the range
+  //-------------------------------------
+};
+#endif
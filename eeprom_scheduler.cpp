@@ -0,0 +1,736 @@
+/***********************************************************
+I/O scheduler over an EEPROM.
+************************************************************/
+#include "eeprom_scheduler.h"
+
+/**
+ * EEPROMScheduler(EEPROM &ep)
+ *
+ * Constructor, enable the reads during the write cycle of the eeprom until the destructor
+ * @param ep eeprom to schedule (EEPROM&)
+ * @return none
+ */
+EEPROMScheduler::EEPROMScheduler(EEPROM &ep) : _ep(ep)
+{
+  _errnum = EEPROM_NoError;
+  _count = 0;
+  _ticket = 0;
+  _unit = ep.getPageSize();
+  _guard = 0;
+  _foreground = us_ticker_read();
+  _last_page = 0;
+  _hold_up = 0;
+
+  // Page programs return at once, the write cycle runs while the scheduler does other work
+  _read_while_write = ep.setReadWhileWrite(true);
+
+  resetStatistics();
+}
+
+/**
+ * ~EEPROMScheduler()
+ *
+ * Destructor, restore the read during write cycle mode of the eeprom, the queued requests are dropped
+ * @param none
+ * @return none
+ */
+EEPROMScheduler::~EEPROMScheduler()
+{
+  _ep.setReadWhileWrite(_read_while_write);
+}
+
+/**
+ * uint32_t write(uint32_t address, const void *data, uint32_t size, Priority priority, uint32_t deadline)
+ *
+ * Queue a write, the data buffer must stay valid until the request is done
+ * @param address start address (uint32_t)
+ * @param data data to write (const void *)
+ * @param size number of bytes to write (uint32_t)
+ * @param priority request priority (Priority)
+ * @param deadline deadline in us from now, 0 if none (uint32_t)
+ * @return request ticket, 0 on error (uint32_t)
+ */
+uint32_t EEPROMScheduler::write(uint32_t address, const void *data, uint32_t size, Priority priority, uint32_t deadline)
+{
+  return (queue(address, (int8_t *)data, size, priority, deadline, true));
+}
+
+/**
+ * uint32_t read(uint32_t address, void *data, uint32_t size, Priority priority, uint32_t deadline)
+ *
+ * Read, at once for a Critical read, overwise queued and the data buffer
+ * must stay valid until the request is done
+ * @param address start address (uint32_t)
+ * @param data data to read (void *)
+ * @param size number of bytes to read (uint32_t)
+ * @param priority request priority (Priority)
+ * @param deadline deadline in us from now, 0 if none (uint32_t)
+ * @return request ticket, 0 on error (uint32_t)
+ */
+uint32_t EEPROMScheduler::read(uint32_t address, void *data, uint32_t size, Priority priority, uint32_t deadline)
+{
+  uint32_t start;
+
+  if (priority != Critical)
+    return (queue(address, (int8_t *)data, size, priority, deadline, false));
+
+  // Check error
+  if (_errnum)
+    return (0);
+
+  start = us_ticker_read();
+
+  // Waits at most the end of the page in write cycle
+  _ep.read(address, (int8_t *)data, size);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (0);
+  }
+
+  // Data not yet programmed
+  overlay(address, (int8_t *)data, size, _ticket + 1);
+
+  latency(priority, start);
+  if (deadline && us_ticker_read() - start > deadline)
+    _misses[priority]++;
+
+  _foreground = us_ticker_read();
+
+  return (++_ticket);
+}
+
+/**
+ * bool process(void)
+ *
+ * Run one unit (page program or page sized read) if the eeprom is ready, never waits
+ * @param none
+ * @return true if requests remain in the queue, overwise false (bool)
+ */
+bool EEPROMScheduler::process(void)
+{
+  return (step(false));
+}
+
+/**
+ * void flush(void)
+ *
+ * Run all the queued requests, background ones included without guard time
+ * @param none
+ * @return none
+ */
+void EEPROMScheduler::flush(void)
+{
+  while (step(true))
+    ;
+
+  // Last page program
+  _ep.ready();
+}
+
+/**
+ * bool isDone(uint32_t ticket)
+ *
+ * Check if a request is done
+ * @param ticket request ticket (uint32_t)
+ * @return true if done, overwise false (bool)
+ */
+bool EEPROMScheduler::isDone(uint32_t ticket)
+{
+  uint8_t i;
+
+  for (i = 0; i < _count; i++)
+  {
+    if (_jobs[i].ticket == ticket)
+      return (false);
+  }
+
+  return (true);
+}
+
+/**
+ * uint8_t getPending(void)
+ *
+ * Get the number of queued requests
+ * @param none
+ * @return number of requests (uint8_t)
+ */
+uint8_t EEPROMScheduler::getPending(void)
+{
+  return (_count);
+}
+
+/**
+ * uint32_t getReadLatencyMax(Priority priority)
+ *
+ * Get the worst read latency, from request to data, since the last reset
+ * @param priority request priority (Priority)
+ * @return latency in us (uint32_t)
+ */
+uint32_t EEPROMScheduler::getReadLatencyMax(Priority priority)
+{
+  return (_latency_max[priority]);
+}
+
+/**
+ * uint32_t getDeadlineMisses(Priority priority)
+ *
+ * Get the number of requests done after their deadline since the last reset
+ * @param priority request priority (Priority)
+ * @return number of deadline misses (uint32_t)
+ */
+uint32_t EEPROMScheduler::getDeadlineMisses(Priority priority)
+{
+  return (_misses[priority]);
+}
+
+/**
+ * void setBackgroundGuard(uint32_t guard)
+ *
+ * Set the time the foreground must leave the bus idle before background requests run
+ * @param guard guard time in us (uint32_t)
+ * @return none
+ */
+void EEPROMScheduler::setBackgroundGuard(uint32_t guard)
+{
+  _guard = guard;
+}
+
+/**
+ * void resetStatistics(void)
+ *
+ * Reset the latency and deadline statistics
+ * @param none
+ * @return none
+ */
+void EEPROMScheduler::resetStatistics(void)
+{
+  memset(_latency_max, 0, sizeof(_latency_max));
+  memset(_misses, 0, sizeof(_misses));
+}
+
+/**
+ * void setHoldUpTime(uint32_t hold_up)
+ *
+ * Set the hold-up time available to powerFail
+ * @param hold_up hold-up time in us (uint32_t)
+ * @return none
+ */
+void EEPROMScheduler::setHoldUpTime(uint32_t hold_up)
+{
+  _hold_up = hold_up;
+}
+
+/**
+ * void powerFail(PowerFailReport &report)
+ *
+ * Commit the queued writes that fit in the hold-up time, to be called on brown-out.
+ * The bus budget of the eeprom is suspended during the flush, so that the plan is not
+ * delayed by token waits, then left as the application had set it. Queued reads are discarded, the queue is empty on return
+ * @param report what has been programmed and dropped (PowerFailReport&)
+ * @return none
+ */
+void EEPROMScheduler::powerFail(PowerFailReport &report)
+{
+  uint8_t order[SCHEDULER_QueueSize];
+  bool dropped[SCHEDULER_QueueSize];
+  uint32_t remaining = _hold_up;
+  uint32_t page, last;
+  uint8_t count = 0;
+  uint8_t i, j, k;
+  Job *job;
+
+  memset(&report, 0, sizeof(report));
+  memset(dropped, 0, sizeof(dropped));
+
+  // No token wait in the flush, the plan only counts the transfer and write cycle times
+  report.budget_suspended = _ep.suspendBusBudget(true);
+
+  // Page in write cycle, counted as a whole tWR
+  if (!_ep.isReady())
+  {
+    remaining -= (remaining < _ep.getProgramTime(0)) ? remaining : _ep.getProgramTime(0);
+    _ep.ready();
+  }
+
+  // Write requests by priority, then oldest first
+  for (i = 0; i < _count; i++)
+  {
+    if (!_jobs[i].write)
+      continue;
+
+    for (j = count; j > 0; j--)
+    {
+      job = &_jobs[order[j - 1]];
+      if (job->priority < _jobs[i].priority || (job->priority == _jobs[i].priority && job->ticket < _jobs[i].ticket))
+        break;
+      order[j] = order[j - 1];
+    }
+    order[j] = i;
+    count++;
+  }
+
+  // Whole dirty pages, each page holds the bytes of all the requests touching it
+  for (k = 0; k < count && !_errnum; k++)
+  {
+    job = &_jobs[order[k]];
+    last = (job->address + job->size - 1) / _unit;
+    for (page = (job->address + job->done) / _unit; page <= last && !_errnum; page++)
+    {
+      if (!handled(page, order, k))
+        commitPage(page, remaining, dropped, report);
+    }
+  }
+
+  // Last page program, then the bus budget state of the application
+  _ep.ready();
+  _ep.suspendBusBudget(report.budget_suspended);
+
+  report.time_planned = _hold_up - remaining;
+  for (i = 0; i < _count; i++)
+  {
+    if (dropped[i])
+      report.dropped[report.dropped_count++] = _jobs[i].ticket;
+  }
+
+  _count = 0;
+}
+
+/**
+ * uint8_t getError(void)
+ *
+ * Get the current error number (EEPROM_NoError if no error)
+ * @param none
+ * @return none
+ */
+uint8_t EEPROMScheduler::getError(void)
+{
+  return (_errnum);
+}
+
+/**
+ * uint32_t queue(uint32_t address, int8_t *data, uint32_t size, Priority priority, uint32_t deadline, bool write)
+ *
+ * Queue a request, run the queue while it is full
+ * @param address start address (uint32_t)
+ * @param data data buffer (int8_t *)
+ * @param size number of bytes (uint32_t)
+ * @param priority request priority (Priority)
+ * @param deadline deadline in us from now, 0 if none (uint32_t)
+ * @param write write request (bool)
+ * @return request ticket, 0 on error (uint32_t)
+ */
+uint32_t EEPROMScheduler::queue(uint32_t address, int8_t *data, uint32_t size, Priority priority, uint32_t deadline, bool write)
+{
+  Job *job;
+
+  // Check error
+  if (_errnum)
+    return (0);
+
+  // Check parameters
+  if (size == 0 || priority >= PriorityCount)
+  {
+    _errnum = EEPROM_ParamError;
+    return (0);
+  }
+
+  // Check address
+  if (address + size > _ep.getSize())
+  {
+    _errnum = EEPROM_OutOfRange;
+    return (0);
+  }
+
+  while (_count == SCHEDULER_QueueSize && step(true))
+    ;
+
+  if (_errnum)
+    return (0);
+
+  job = &_jobs[_count++];
+  job->ticket = ++_ticket;
+  job->address = address;
+  job->data = data;
+  job->size = size;
+  job->done = 0;
+  job->start = us_ticker_read();
+  job->deadline = job->start + deadline;
+  job->has_deadline = (deadline != 0);
+  job->priority = priority;
+  job->write = write;
+
+  if (priority != Background)
+    _foreground = job->start;
+
+  return (job->ticket);
+}
+
+/**
+ * bool step(bool all)
+ *
+ * Run one unit if the eeprom is ready
+ * @param all run background requests without guard time (bool)
+ * @return true if requests remain in the queue, overwise false (bool)
+ */
+bool EEPROMScheduler::step(bool all)
+{
+  int index;
+
+  // Check error
+  if (_errnum)
+    return (false);
+
+  if (_count == 0)
+    return (false);
+
+  if (!_ep.isReady())
+    return (true);
+
+  index = next(all);
+  if (index >= 0)
+    runUnit(index);
+
+  return (_count != 0 && !_errnum);
+}
+
+/**
+ * int next(bool all)
+ *
+ * Next runnable request, background ones only when the foreground leaves the bus idle
+ * @param all run background requests without guard time (bool)
+ * @return request index, -1 if none (int)
+ */
+int EEPROMScheduler::next(bool all)
+{
+  int best = -1;
+  uint8_t i;
+
+  for (i = 0; i < _count; i++)
+  {
+    if (blocked(i))
+      continue;
+
+    if (best < 0 || before(&_jobs[i], &_jobs[best]))
+      best = i;
+  }
+
+  if (best < 0 || all || _jobs[best].priority != Background)
+    return (best);
+
+  // A foreground request waiting a background one makes it run at once
+  for (i = 0; i < _count; i++)
+  {
+    if (_jobs[i].priority != Background)
+      return (best);
+  }
+
+  // Leftover bus time only for the background
+  if (us_ticker_read() - _foreground < _guard)
+    return (-1);
+
+  return (best);
+}
+
+/**
+ * bool before(Job *a, Job *b)
+ *
+ * Scheduling order : priority class, earliest deadline, page of the last unit, oldest
+ * @param a first request (Job *)
+ * @param b second request (Job *)
+ * @return true if a runs before b, overwise false (bool)
+ */
+bool EEPROMScheduler::before(Job *a, Job *b)
+{
+  bool a_local, b_local;
+
+  if (a->priority != b->priority)
+    return (a->priority < b->priority);
+
+  if (a->has_deadline != b->has_deadline)
+    return (a->has_deadline);
+  if (a->has_deadline && a->deadline != b->deadline)
+    return ((int32_t)(a->deadline - b->deadline) < 0);
+
+  a_local = (a->address + a->done) / _unit == _last_page;
+  b_local = (b->address + b->done) / _unit == _last_page;
+  if (a_local != b_local)
+    return (a_local);
+
+  return (a->ticket < b->ticket);
+}
+
+/**
+ * bool blocked(int index)
+ *
+ * Check if a request must wait an older one touching the same bytes, one of them being a write
+ * @param index request index (int)
+ * @return true if the request must wait, overwise false (bool)
+ */
+bool EEPROMScheduler::blocked(int index)
+{
+  Job *job = &_jobs[index];
+  Job *older;
+  uint8_t i;
+
+  for (i = 0; i < _count; i++)
+  {
+    older = &_jobs[i];
+    if (older->ticket >= job->ticket || (!older->write && !job->write))
+      continue;
+
+    // Remaining ranges overlap
+    if (older->address + older->done < job->address + job->size &&
+        job->address + job->done < older->address + older->size)
+      return (true);
+  }
+
+  return (false);
+}
+
+/**
+ * void runUnit(int index)
+ *
+ * Run one unit of a request, up to the end of the page
+ * @param index request index (int)
+ * @return none
+ */
+void EEPROMScheduler::runUnit(int index)
+{
+  Job *job = &_jobs[index];
+  uint32_t address;
+  uint32_t count;
+
+  address = job->address + job->done;
+  count = _unit - address % _unit;
+  if (count > job->size - job->done)
+    count = job->size - job->done;
+
+  if (job->write)
+    _ep.write(address, job->data + job->done, count);
+  else
+    _ep.read(address, job->data + job->done, count);
+
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return;
+  }
+
+  _last_page = address / _unit;
+  if (job->priority != Background)
+    _foreground = us_ticker_read();
+
+  job->done += count;
+  if (job->done < job->size)
+    return;
+
+  if (!job->write)
+    latency(job->priority, job->start);
+  finished(job);
+
+  // Remove the request
+  *job = _jobs[--_count];
+}
+
+/**
+ * void overlay(uint32_t address, int8_t *data, uint32_t size, uint32_t ticket)
+ *
+ * Apply the data of the queued writes older than ticket, not yet programmed, in submission order
+ * @param address start address (uint32_t)
+ * @param data data read (int8_t *)
+ * @param size number of bytes (uint32_t)
+ * @param ticket ticket of the read (uint32_t)
+ * @return none
+ */
+void EEPROMScheduler::overlay(uint32_t address, int8_t *data, uint32_t size, uint32_t ticket)
+{
+  uint32_t last = 0;
+  uint32_t start, end;
+  Job *job;
+  int index;
+  uint8_t i;
+
+  while (true)
+  {
+    // Oldest write after the last applied one
+    index = -1;
+    for (i = 0; i < _count; i++)
+    {
+      if (_jobs[i].write && _jobs[i].ticket > last && _jobs[i].ticket < ticket &&
+          (index < 0 || _jobs[i].ticket < _jobs[index].ticket))
+        index = i;
+    }
+    if (index < 0)
+      return;
+
+    job = &_jobs[index];
+    last = job->ticket;
+
+    start = job->address + job->done;
+    if (start < address)
+      start = address;
+    end = job->address + job->size;
+    if (end > address + size)
+      end = address + size;
+
+    if (start < end)
+      memcpy(data + (start - address), job->data + (start - job->address), end - start);
+  }
+}
+
+/**
+ * void latency(uint8_t priority, uint32_t start)
+ *
+ * Update the read latency statistics
+ * @param priority request priority (uint8_t)
+ * @param start request time (us) (uint32_t)
+ * @return none
+ */
+void EEPROMScheduler::latency(uint8_t priority, uint32_t start)
+{
+  uint32_t elapsed = us_ticker_read() - start;
+
+  if (elapsed > _latency_max[priority])
+    _latency_max[priority] = elapsed;
+}
+
+/**
+ * void finished(Job *job)
+ *
+ * Update the deadline statistics of a request done
+ * @param job request done (Job *)
+ * @return none
+ */
+void EEPROMScheduler::finished(Job *job)
+{
+  if (job->has_deadline && (int32_t)(us_ticker_read() - job->deadline) > 0)
+    _misses[job->priority]++;
+}
+
+/**
+ * bool handled(uint32_t page, uint8_t *order, uint8_t count)
+ *
+ * Check if a page has been committed or dropped with one of the first write requests
+ * @param page page number (uint32_t)
+ * @param order write requests in power fail order (uint8_t *)
+ * @param count number of write requests already handled (uint8_t)
+ * @return true if the page has been handled, overwise false (bool)
+ */
+bool EEPROMScheduler::handled(uint32_t page, uint8_t *order, uint8_t count)
+{
+  Job *job;
+  uint8_t k;
+
+  for (k = 0; k < count; k++)
+  {
+    job = &_jobs[order[k]];
+    if ((job->address + job->done) / _unit <= page && page <= (job->address + job->size - 1) / _unit)
+      return (true);
+  }
+
+  return (false);
+}
+
+/**
+ * bool commitPage(uint32_t page, uint32_t &remaining, bool *dropped, PowerFailReport &report)
+ *
+ * Program the dirty bytes of a page in one page program if it fits in the remaining time.
+ * Clean bytes between dirty ones are read back from the eeprom first
+ * @param page page number (uint32_t)
+ * @param remaining remaining hold-up time in us (uint32_t&)
+ * @param dropped write requests not fully programmed, by request index (bool *)
+ * @param report power fail report (PowerFailReport&)
+ * @return true if the page has been programmed, overwise false (bool)
+ */
+bool EEPROMScheduler::commitPage(uint32_t page, uint32_t &remaining, bool *dropped, PowerFailReport &report)
+{
+  uint32_t base = page * _unit;
+  uint32_t first = _unit, last = 0;
+  uint32_t start, end, cost, dirty = 0;
+  uint32_t ticket = 0;
+  int index;
+  uint8_t i;
+  Job *job;
+
+  // Dirty bytes of the page
+  memset(_dirty, 0, sizeof(_dirty));
+  for (i = 0; i < _count; i++)
+  {
+    job = &_jobs[i];
+    start = job->address + job->done;
+    end = job->address + job->size;
+    if (!job->write || start >= base + _unit || end <= base)
+      continue;
+
+    start = (start > base) ? start - base : 0;
+    end = (end < base + _unit) ? end - base : _unit;
+    if (start < first)
+      first = start;
+    if (end > last)
+      last = end;
+    for (; start < end; start++)
+      _dirty[start / 8] |= 1 << (start % 8);
+  }
+
+  for (start = first; start < last; start++)
+  {
+    if (_dirty[start / 8] & (1 << (start % 8)))
+      dirty++;
+  }
+
+  cost = _ep.getProgramTime(last - first);
+  if (dirty != last - first)
+    cost += _ep.getTransferTime(last - first);
+
+  if (cost > remaining)
+  {
+    report.pages_dropped++;
+    report.bytes_dropped += dirty;
+    for (i = 0; i < _count; i++)
+    {
+      if (_jobs[i].write && _jobs[i].address + _jobs[i].done < base + _unit && _jobs[i].address + _jobs[i].size > base)
+        dropped[i] = true;
+    }
+    return (false);
+  }
+  remaining -= cost;
+
+  // Clean bytes inside the programmed range
+  if (dirty != last - first)
+    _ep.read(base + first, _page + first, last - first);
+
+  // Requests applied in submission order
+  while (true)
+  {
+    index = -1;
+    for (i = 0; i < _count; i++)
+    {
+      if (_jobs[i].write && _jobs[i].ticket > ticket && (index < 0 || _jobs[i].ticket < _jobs[index].ticket))
+        index = i;
+    }
+    if (index < 0)
+      break;
+
+    job = &_jobs[index];
+    ticket = job->ticket;
+    start = job->address + job->done;
+    end = job->address + job->size;
+    if (start < base + first)
+      start = base + first;
+    if (end > base + last)
+      end = base + last;
+    if (start < end)
+      memcpy(_page + (start - base), job->data + (start - job->address), end - start);
+  }
+
+  _ep.write(base + first, _page + first, last - first);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  report.pages_programmed++;
+  return (true);
+}
@@ -0,0 +1,262 @@
+#ifndef __EEPROM_SCHEDULER__H_
+#define __EEPROM_SCHEDULER__H_
+
+/***********************************************************
+I/O scheduler over an EEPROM.
+
+Long writes and reads are queued and split into page units, process()
+runs one unit at a time without waiting the write cycle of the chip.
+Critical reads are served at once, between two page programs : they
+only wait the end of the page in write cycle, and see the data of the
+writes still in the queue.
+
+The other requests are served by priority class, then earliest deadline,
+then on the page of the last unit, then oldest first. A request never
+passes an older one touching the same bytes if one of them is a write.
+Background requests only run when no foreground request is runnable and
+the bus has been left idle by the foreground for the guard time (unless
+a foreground request waits for them, or on flush).
+Requests finishing after their deadline are counted as misses.
+
+On power fail, powerFail() commits the queued writes within the hold-up
+time : the dirty bytes of all the queued writes are merged per page so
+that each page costs one page program, pages are committed in priority
+order and the ones that do not fit in the remaining time are dropped
+and reported. The bus budget of the eeprom (setBusBudget) does not apply
+to this flush.
+
+Data buffers given to read and write must stay valid until the
+request is done (see isDone).
+
+The scheduler enables the reads during the write cycle of the eeprom
+(setReadWhileWrite) while it exists : the other users of the eeprom
+then get writes that return before the end of the write cycle. The
+previous mode is restored by the destructor.
+
+Not thread safe : all calls must come from the same context.
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom.h"
+#include "eeprom_scheduler.h"
+
+EEPROM ep(p9,p10,0,EEPROM::T24C256);
+EEPROMScheduler sched(ep);
+int8_t log_buffer[4096];
+
+int main()
+{
+  int32_t setpoint;
+  uint32_t ticket;
+
+  sched.setBackgroundGuard(2000);
+  ticket = sched.write(0x1000,log_buffer,sizeof(log_buffer),EEPROMScheduler::Background);
+  while(!sched.isDone(ticket)) {
+    sched.read(0,&setpoint,sizeof(setpoint),EEPROMScheduler::Critical,1000);
+    // control loop ...
+    sched.process();
+  }
+  printf("worst read latency %u us, %u misses\n",sched.getReadLatencyMax(EEPROMScheduler::Critical),
+         sched.getDeadlineMisses(EEPROMScheduler::Critical));
+
+  return(0);
+}
+*/
+
+// Defines
+#define SCHEDULER_QueueSize 8
+
+/** Power fail flush report
+ */
+struct PowerFailReport
+{
+  uint32_t pages_programmed;             // Page programs done
+  uint32_t pages_dropped;                // Dirty pages not programmed
+  uint32_t bytes_dropped;                // Dirty bytes not programmed
+  uint32_t time_planned;                 // Flush time planned from the page program times (us)
+  bool budget_suspended;                 // Bus budget already suspended by the application, kept after the flush
+  uint8_t dropped_count;                 // Number of write requests not fully programmed
+  uint32_t dropped[SCHEDULER_QueueSize]; // Tickets of the write requests not fully programmed
+};
+
+/** EEPROMScheduler Class
+ */
+class EEPROMScheduler
+{
+public:
+  enum Priority
+  {
+    Critical,
+    Normal,
+    Background,
+    PriorityCount
+  };
+
+  /**
+   * Constructor, enable the reads during the write cycle of the eeprom until the destructor
+   * @param ep eeprom to schedule (EEPROM&)
+   * @return none
+   */
+  EEPROMScheduler(EEPROM &ep);
+
+  /**
+   * Destructor, restore the read during write cycle mode of the eeprom, the queued requests are dropped
+   * @param none
+   * @return none
+   */
+  ~EEPROMScheduler();
+
+  /**
+   * Queue a write, the data buffer must stay valid until the request is done
+   * @param address start address (uint32_t)
+   * @param data data to write (const void *)
+   * @param size number of bytes to write (uint32_t)
+   * @param priority request priority (Priority)
+   * @param deadline deadline in us from now, 0 if none (uint32_t)
+   * @return request ticket, 0 on error (uint32_t)
+   */
+  uint32_t write(uint32_t address, const void *data, uint32_t size, Priority priority = Normal, uint32_t deadline = 0);
+
+  /**
+   * Read, at once for a Critical read, overwise queued and the data buffer
+   * must stay valid until the request is done
+   * @param address start address (uint32_t)
+   * @param data data to read (void *)
+   * @param size number of bytes to read (uint32_t)
+   * @param priority request priority (Priority)
+   * @param deadline deadline in us from now, 0 if none (uint32_t)
+   * @return request ticket, 0 on error (uint32_t)
+   */
+  uint32_t read(uint32_t address, void *data, uint32_t size, Priority priority = Normal, uint32_t deadline = 0);
+
+  /**
+   * Run one unit (page program or page sized read) if the eeprom is ready, never waits
+   * @param none
+   * @return true if requests remain in the queue, overwise false (bool)
+   */
+  bool process(void);
+
+  /**
+   * Run all the queued requests
+   * @param none
+   * @return none
+   */
+  void flush(void);
+
+  /**
+   * Check if a request is done
+   * @param ticket request ticket (uint32_t)
+   * @return true if done, overwise false (bool)
+   */
+  bool isDone(uint32_t ticket);
+
+  /**
+   * Get the number of queued requests
+   * @param none
+   * @return number of requests (uint8_t)
+   */
+  uint8_t getPending(void);
+
+  /**
+   * Get the worst read latency, from request to data, since the last reset
+   * @param priority request priority (Priority)
+   * @return latency in us (uint32_t)
+   */
+  uint32_t getReadLatencyMax(Priority priority);
+
+  /**
+   * Get the number of requests done after their deadline since the last reset
+   * @param priority request priority (Priority)
+   * @return number of deadline misses (uint32_t)
+   */
+  uint32_t getDeadlineMisses(Priority priority);
+
+  /**
+   * Set the time the foreground must leave the bus idle before background requests run
+   * @param guard guard time in us (uint32_t)
+   * @return none
+   */
+  void setBackgroundGuard(uint32_t guard);
+
+  /**
+   * Reset the latency and deadline statistics
+   * @param none
+   * @return none
+   */
+  void resetStatistics(void);
+
+  /**
+   * Set the hold-up time available to powerFail
+   * @param hold_up hold-up time in us (uint32_t)
+   * @return none
+   */
+  void setHoldUpTime(uint32_t hold_up);
+
+  /**
+   * Commit the queued writes that fit in the hold-up time, to be called on brown-out
+   * (from the interrupt only if the bus api can be used there). The bus budget of the
+   * eeprom is suspended during the flush, so that the plan is not delayed by token waits,
+   * then left as the application had set it.
+   * Queued reads are discarded, the queue is empty on return
+   * @param report what has been programmed and dropped (PowerFailReport&)
+   * @return none
+   */
+  void powerFail(PowerFailReport &report);
+
+  /**
+   * Get the current error number (EEPROM_NoError if no error)
+   * @param  none
+   * @return none
+   */
+  uint8_t getError(void);
+
+  //---------- local variables ----------
+private:
+  struct Job
+  {
+    uint32_t ticket;                   // Request ticket (submission order)
+    uint32_t address;                  // Start address
+    int8_t *data;                      // Data buffer
+    uint32_t size;                     // Number of bytes
+    uint32_t done;                     // Number of bytes done
+    uint32_t start;                    // Submission time (us)
+    uint32_t deadline;                 // Absolute deadline (us)
+    bool has_deadline;                 // Deadline set
+    uint8_t priority;                  // Request priority
+    bool write;                        // Write request
+  };
+
+  EEPROM &_ep;                         // Scheduled eeprom
+  Job _jobs[SCHEDULER_QueueSize];      // Queued requests (no order)
+  uint8_t _count;                      // Number of queued requests
+  uint32_t _ticket;                    // Last ticket
+  uint16_t _unit;                      // Unit size in bytes (page size)
+  uint8_t _errnum;                     // Error number
+  uint32_t _latency_max[PriorityCount]; // Worst read latency (us)
+  uint32_t _misses[PriorityCount];     // Deadline misses
+  uint32_t _guard;                     // Background guard time (us)
+  uint32_t _foreground;                // Last foreground activity (us)
+  uint32_t _last_page;                 // Page of the last unit
+  uint32_t _hold_up;                   // Hold-up time (us)
+  bool _read_while_write;              // Read during write cycle mode of the eeprom before the scheduler
+  int8_t _page[MAX_PAGE_SIZE];         // Power fail page buffer
+  uint8_t _dirty[MAX_PAGE_SIZE / 8];   // Power fail dirty bytes of the page
+  uint32_t queue(uint32_t address, int8_t *data, uint32_t size, Priority priority, uint32_t deadline, bool write); // Queue a request
+  bool step(bool all);                 // Run one unit
+  int next(bool all);                  // Next runnable request
+  bool before(Job *a, Job *b);         // Scheduling order
+  bool blocked(int index);             // Request waiting an older one
+  void runUnit(int index);             // Run one unit of a request
+  void overlay(uint32_t address, int8_t *data, uint32_t size, uint32_t ticket); // Apply queued writes
+  void latency(uint8_t priority, uint32_t start); // Update statistics
+  void finished(Job *job);             // Deadline statistics
+  bool handled(uint32_t page, uint8_t *order, uint8_t count); // Page committed or dropped
+  bool commitPage(uint32_t page, uint32_t &remaining, bool *dropped, PowerFailReport &report); // Power fail page program
+  //-------------------------------------
+};
+#endif
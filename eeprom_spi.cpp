@@ -0,0 +1,178 @@
+/***********************************************************
+SPI EEPROM (25xx series) backend.
+************************************************************/
+#include "eeprom_spi.h"
+
+/**
+ * EEPROMSPI(PinName mosi, PinName miso, PinName sclk, PinName cs, TypeEeprom type, int frequency)
+ *
+ * Constructor, initialize the eeprom on spi interface.
+ * @param mosi mosi spi pin (PinName)
+ * @param miso miso spi pin (PinName)
+ * @param sclk sclk spi pin (PinName)
+ * @param cs chip select pin (PinName)
+ * @param type eeprom type, one of the T25LCxxx types (TypeEeprom)
+ * @param frequency spi clock in Hz (int)
+ * @return none
+ */
+EEPROMSPI::EEPROMSPI(PinName mosi, PinName miso, PinName sclk, PinName cs, TypeEeprom type, int frequency)
+    : EEPROMSPI(mosi, miso, sclk, cs, getDescriptor(type), frequency)
+{
+}
+
+/**
+ * EEPROMSPI(PinName mosi, PinName miso, PinName sclk, PinName cs, const EEPROMDescriptor &desc, int frequency)
+ *
+ * Constructor for a device described by the caller, initialize the eeprom on spi interface.
+ * @param mosi mosi spi pin (PinName)
+ * @param miso miso spi pin (PinName)
+ * @param sclk sclk spi pin (PinName)
+ * @param cs chip select pin (PinName)
+ * @param desc device descriptor, copied (const EEPROMDescriptor&)
+ * @param frequency spi clock in Hz (int)
+ * @return none
+ */
+EEPROMSPI::EEPROMSPI(PinName mosi, PinName miso, PinName sclk, PinName cs, const EEPROMDescriptor &desc, int frequency)
+    : EEPROM(desc), _spi(mosi, miso, sclk), _cs(cs, 1)
+{
+  _current = 0;
+
+  // Check descriptor
+  if (!desc.spi || desc.address_bytes < 1 || desc.address_bytes > 3)
+    _errnum = EEPROM_ParamError;
+
+  // Mode 0, 8 bits
+  _spi.format(8, 0);
+  _spi.frequency(frequency);
+  _bus_frequency = frequency;
+  _bus_clocks = 8;
+}
+
+/**
+ * bool busReady(void)
+ *
+ * Single ready probe, WIP bit of the status register
+ * @param none
+ * @return true if the eeprom is ready, overwise false (bool)
+ */
+bool EEPROMSPI::busReady(void)
+{
+  int status;
+
+  _spi.lock();
+  _cs = 0;
+  _spi.write(EEPROM_SPI_RDSR);
+  status = _spi.write(0);
+  _cs = 1;
+  _spi.unlock();
+
+  return ((status & EEPROM_SPI_WIP) == 0);
+}
+
+/**
+ * void busRead(uint32_t address, int8_t *data, uint32_t size)
+ *
+ * Sequential read with a single READ command, address range already checked
+ * @param address start address (uint32_t)
+ * @param data bytes array to read (int8_t *)
+ * @param size number of bytes to read (uint32_t)
+ * @return none
+ */
+void EEPROMSPI::busRead(uint32_t address, int8_t *data, uint32_t size)
+{
+  int8_t cmd[EEPROM_FrameHeader];
+  uint8_t len;
+
+  len = command(EEPROM_SPI_READ, address, cmd);
+
+  _spi.lock();
+  _cs = 0;
+  _spi.write((const char *)cmd, len, NULL, 0);
+  _spi.write(NULL, 0, (char *)data, size);
+  _cs = 1;
+  _spi.unlock();
+
+  _current = (address + size) % _size;
+}
+
+/**
+ * void busReadCurrent(int8_t &data)
+ *
+ * Current address read byte, emulated with the address following the last access
+ * @param data byte to read (int8_t&)
+ * @return none
+ */
+void EEPROMSPI::busReadCurrent(int8_t &data)
+{
+  busRead(_current, &data, 1);
+}
+
+/**
+ * void busWrite(uint32_t address, int8_t *data, uint32_t size)
+ *
+ * Page program (WREN then WRITE), address range already checked. The instruction,
+ * the address and the data are assembled in _frame and sent with one bus call, the
+ * bus is held from WREN to the end of WRITE. Does not wait the end of the write cycle
+ * @param address start address (uint32_t)
+ * @param data bytes array to write (int8_t *)
+ * @param size number of bytes to write, inside one page (uint32_t)
+ * @return none
+ */
+void EEPROMSPI::busWrite(uint32_t address, int8_t *data, uint32_t size)
+{
+  int8_t *header;
+  uint32_t count;
+  uint8_t len;
+
+  len = 1 + _desc.address_bytes;
+  header = _frame + EEPROM_FrameHeader - len;
+
+  while (size)
+  {
+    count = (size < MAX_PAGE_SIZE) ? size : MAX_PAGE_SIZE;
+    command(EEPROM_SPI_WRITE, address, header);
+    memcpy(_frame + EEPROM_FrameHeader, data, count);
+
+    _spi.lock();
+
+    // Write enable latch, reset by the chip at the end of every write
+    _cs = 0;
+    _spi.write(EEPROM_SPI_WREN);
+    _cs = 1;
+
+    _cs = 0;
+    _spi.write((const char *)header, len + count, NULL, 0);
+    _cs = 1;
+
+    _spi.unlock();
+
+    address += count;
+    data += count;
+    size -= count;
+  }
+
+  _current = address % _size;
+}
+
+/**
+ * uint8_t command(uint8_t instruction, uint32_t address, int8_t *cmd)
+ *
+ * Build the instruction and address bytes
+ * @param instruction READ or WRITE instruction (uint8_t)
+ * @param address data address (uint32_t)
+ * @param cmd buffer of 1 + address bytes (int8_t *)
+ * @return number of bytes (uint8_t)
+ */
+uint8_t EEPROMSPI::command(uint8_t instruction, uint32_t address, int8_t *cmd)
+{
+  uint8_t l;
+
+  // Address bits above the address bytes (25xx040 A8) are sent in the instruction
+  cmd[0] = (int8_t)(instruction | (uint8_t)((address >> (8 * _desc.address_bytes)) << _desc.block_shift));
+
+  // MSB first
+  for (l = 0; l < _desc.address_bytes; l++)
+    cmd[1 + l] = (int8_t)(address >> (8 * (_desc.address_bytes - l - 1)));
+
+  return (1 + _desc.address_bytes);
+}
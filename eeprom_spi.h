@@ -0,0 +1,88 @@
+#ifndef __EEPROM_SPI__H_
+#define __EEPROM_SPI__H_
+
+/***********************************************************
+SPI EEPROM (25xx series) backend.
+
+Same read/write/fill/clear api as the i2c EEPROM class, so that all
+the higher level features taking an EEPROM& work on SPI parts too.
+Only the bus primitives are replaced :
+  - sequential read is a single READ command of any length,
+  - page program is WREN followed by WRITE,
+  - end of write is detected by polling the WIP bit with RDSR.
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom_spi.h"
+
+EEPROMSPI ep(p5,p6,p7,p8,EEPROM::T25LC256);   // mosi, miso, sclk, cs
+
+int main()
+{
+  int32_t boots;
+
+  ep.read((uint32_t)0,boots);
+  ep.write((uint32_t)0,(int32_t)(boots + 1));
+  printf("%s boot %d\n",ep.getName(),boots + 1);
+
+  return(0);
+}
+*/
+
+// Defines
+#define EEPROM_SPI_READ 0x03
+#define EEPROM_SPI_WRITE 0x02
+#define EEPROM_SPI_WREN 0x06
+#define EEPROM_SPI_RDSR 0x05
+
+#define EEPROM_SPI_WIP 0x01
+
+/** EEPROMSPI Class
+ */
+class EEPROMSPI : public EEPROM
+{
+public:
+  /**
+   * Constructor, initialize the eeprom on spi interface.
+   * @param mosi mosi spi pin (PinName)
+   * @param miso miso spi pin (PinName)
+   * @param sclk sclk spi pin (PinName)
+   * @param cs chip select pin (PinName)
+   * @param type eeprom type, one of the T25LCxxx types (TypeEeprom)
+   * @param frequency spi clock in Hz (int)
+   * @return none
+   */
+  EEPROMSPI(PinName mosi, PinName miso, PinName sclk, PinName cs, TypeEeprom type, int frequency = 10000000);
+
+  /**
+   * Constructor for a device described by the caller, initialize the eeprom on spi interface.
+   * @param mosi mosi spi pin (PinName)
+   * @param miso miso spi pin (PinName)
+   * @param sclk sclk spi pin (PinName)
+   * @param cs chip select pin (PinName)
+   * @param desc device descriptor, copied (const EEPROMDescriptor&)
+   * @param frequency spi clock in Hz (int)
+   * @return none
+   */
+  EEPROMSPI(PinName mosi, PinName miso, PinName sclk, PinName cs, const EEPROMDescriptor &desc, int frequency = 10000000);
+
+  //---------- local variables ----------
+protected:
+  virtual void busRead(uint32_t address, int8_t *data, uint32_t size);
+  virtual void busReadCurrent(int8_t &data);
+  virtual void busWrite(uint32_t address, int8_t *data, uint32_t size);
+  virtual bool busReady(void);
+
+private:
+  SPI _spi;                            // Local spi communication interface instance
+  DigitalOut _cs;                      // Chip select (active low)
+  uint32_t _current;                   // Current address, the chip has no current address read
+  uint8_t command(uint8_t instruction, uint32_t address, int8_t *cmd); // Build instruction and address
+  //-------------------------------------
+};
+#endif
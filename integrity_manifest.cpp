@@ -0,0 +1,448 @@
+/***********************************************************
+Integrity manifest of an EEPROM region : a two level hash tree.
+************************************************************/
+#include "integrity_manifest.h"
+
+/**
+ * IntegrityManifest(EEPROM &ep, uint32_t address, uint32_t size, uint32_t manifest, uint16_t group_pages)
+ *
+ * Constructor, no access is done to the eeprom
+ * @param ep eeprom holding the region (EEPROM&)
+ * @param address start address of the region, page aligned (uint32_t)
+ * @param size region size in bytes, multiple of the page size (uint32_t)
+ * @param manifest address of the manifest, outside the region, aligned up to the record size (uint32_t)
+ * @param group_pages pages per group, up to MANIFEST_MaxRecord / MANIFEST_HashSize - 1 (uint16_t)
+ * @return none
+ */
+IntegrityManifest::IntegrityManifest(EEPROM &ep, uint32_t address, uint32_t size, uint32_t manifest, uint16_t group_pages) : _ep(ep)
+{
+  uint32_t align;
+
+  _errnum = EEPROM_NoError;
+  _address = address;
+  _page_size = ep.getPageSize();
+  _group_pages = group_pages;
+  _pages = 0;
+  _groups = 0;
+  _random = 0;
+
+  // Record : power of 2, so that it does not straddle a page
+  for (_record = 1; _record < (uint32_t)(group_pages + 1) * MANIFEST_HashSize; _record <<= 1)
+    ;
+  align = (_record < _page_size) ? _record : _page_size;
+  _manifest = (manifest + align - 1) / align * align;
+  _manifest_size = _manifest - manifest;
+
+  if (!group_pages || _record > MANIFEST_MaxRecord || !size || address % _page_size || size % _page_size)
+  {
+    _errnum = EEPROM_ParamError;
+    return;
+  }
+
+  _pages = size / _page_size;
+  _groups = (_pages + group_pages - 1) / group_pages;
+  _manifest_size += (_groups + 1) * _record;
+
+  if (address + size > ep.getSize() || manifest + _manifest_size > ep.getSize())
+    _errnum = EEPROM_OutOfRange;
+  else if (manifest < address + size && address < manifest + _manifest_size)
+    _errnum = EEPROM_ParamError;
+}
+
+/**
+ * void rebuild(void)
+ *
+ * Compute and write the whole manifest from the region content : one CRC-32
+ * per page, one record program per group and the root
+ * @param none
+ * @return none
+ */
+void IntegrityManifest::rebuild(void)
+{
+  uint8_t record[MANIFEST_MaxRecord];
+  uint32_t root = 0, group, hash, g;
+  uint16_t k, n;
+
+  // Check error
+  if (_errnum)
+    return;
+
+  for (g = 0; g < _groups; g++)
+  {
+    n = groupPages(g);
+    group = 0;
+    for (k = 0; k < n; k++)
+    {
+      hash = _ep.checksum(_address + (g * _group_pages + k) * _page_size, _page_size);
+      if (_ep.getError() != EEPROM_NoError)
+      {
+        _errnum = _ep.getError();
+        return;
+      }
+      memcpy(record + (k + 1) * MANIFEST_HashSize, &hash, MANIFEST_HashSize);
+      group ^= mix(k, hash);
+    }
+    memcpy(record, &group, MANIFEST_HashSize);
+
+    _ep.write(_manifest + (g + 1) * _record, (int8_t *)record, (n + 1) * MANIFEST_HashSize);
+    if (_ep.getError() != EEPROM_NoError)
+    {
+      _errnum = _ep.getError();
+      return;
+    }
+    root ^= mix(g, group);
+  }
+
+  writeWord(_manifest, root);
+}
+
+/**
+ * void write(uint32_t address, void *data, uint32_t size)
+ *
+ * Write in the region and update the manifest
+ * @param address start address (uint32_t)
+ * @param data data to write (void *)
+ * @param size number of bytes to write (uint32_t)
+ * @return none
+ */
+void IntegrityManifest::write(uint32_t address, void *data, uint32_t size)
+{
+  // Check error
+  if (_errnum)
+    return;
+
+  if (address < _address || address + size > _address + _pages * _page_size)
+  {
+    _errnum = EEPROM_OutOfRange;
+    return;
+  }
+
+  _ep.write(address, (int8_t *)data, size);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return;
+  }
+
+  update(address, size);
+}
+
+/**
+ * void update(uint32_t address, uint32_t size)
+ *
+ * Update the manifest after a write done directly on the eeprom : the CRC-32
+ * of each written page is computed again and the group and root hashes are
+ * changed by the difference, the other pages are not read. One record read
+ * and program per written group, then the root
+ * @param address start address of the write (uint32_t)
+ * @param size number of bytes written (uint32_t)
+ * @return none
+ */
+void IntegrityManifest::update(uint32_t address, uint32_t size)
+{
+  uint8_t record[MANIFEST_MaxRecord];
+  uint32_t root, group, old, hash, first, last, g;
+  uint16_t k, k0, k1;
+
+  // Check error
+  if (_errnum || !size)
+    return;
+
+  if (address < _address || address + size > _address + _pages * _page_size)
+  {
+    _errnum = EEPROM_OutOfRange;
+    return;
+  }
+
+  first = (address - _address) / _page_size;
+  last = (address + size - 1 - _address) / _page_size;
+
+  if (!readWord(_manifest, root))
+    return;
+
+  for (g = first / _group_pages; g <= last / _group_pages; g++)
+  {
+    k0 = (first > g * _group_pages) ? first - g * _group_pages : 0;
+    k1 = (last < (g + 1) * _group_pages) ? last - g * _group_pages : _group_pages - 1;
+
+    // Group hash and page hashes up to the last written page
+    _ep.read(_manifest + (g + 1) * _record, (int8_t *)record, (k1 + 2) * MANIFEST_HashSize);
+    if (_ep.getError() != EEPROM_NoError)
+    {
+      _errnum = _ep.getError();
+      return;
+    }
+    memcpy(&group, record, MANIFEST_HashSize);
+    root ^= mix(g, group);
+
+    for (k = k0; k <= k1; k++)
+    {
+      hash = _ep.checksum(_address + (g * _group_pages + k) * _page_size, _page_size);
+      if (_ep.getError() != EEPROM_NoError)
+      {
+        _errnum = _ep.getError();
+        return;
+      }
+      memcpy(&old, record + (k + 1) * MANIFEST_HashSize, MANIFEST_HashSize);
+      memcpy(record + (k + 1) * MANIFEST_HashSize, &hash, MANIFEST_HashSize);
+      group ^= mix(k, old) ^ mix(k, hash);
+    }
+    memcpy(record, &group, MANIFEST_HashSize);
+    root ^= mix(g, group);
+
+    _ep.write(_manifest + (g + 1) * _record, (int8_t *)record, (k1 + 2) * MANIFEST_HashSize);
+    if (_ep.getError() != EEPROM_NoError)
+    {
+      _errnum = _ep.getError();
+      return;
+    }
+  }
+
+  writeWord(_manifest, root);
+}
+
+/**
+ * bool verifyRoot(void)
+ *
+ * Check the root hash against the group hashes, MANIFEST_HashSize bytes read
+ * per group
+ * @param none
+ * @return true if the manifest is consistent, overwise false (bool)
+ */
+bool IntegrityManifest::verifyRoot(void)
+{
+  uint32_t root = 0, stored, group, g;
+
+  // Check error
+  if (_errnum)
+    return (false);
+
+  for (g = 0; g < _groups; g++)
+  {
+    if (!readWord(_manifest + (g + 1) * _record, group))
+      return (false);
+    root ^= mix(g, group);
+  }
+
+  if (!readWord(_manifest, stored))
+    return (false);
+
+  return (root == stored);
+}
+
+/**
+ * int32_t verifyGroup(uint32_t group)
+ *
+ * Check the pages of a group against the manifest : the page hashes of the
+ * record are checked against the group hash, then each page against its hash
+ * @param group group index (uint32_t)
+ * @return index in the region of the first page that differs, -1 if none, MANIFEST_RecordError if the group record is not consistent (int32_t)
+ */
+int32_t IntegrityManifest::verifyGroup(uint32_t group)
+{
+  uint8_t record[MANIFEST_MaxRecord];
+  uint32_t hash, stored, page;
+  uint16_t k, n;
+
+  // Check error
+  if (_errnum)
+    return (-1);
+
+  if (group >= _groups)
+  {
+    _errnum = EEPROM_ParamError;
+    return (-1);
+  }
+
+  n = groupPages(group);
+  _ep.read(_manifest + (group + 1) * _record, (int8_t *)record, (n + 1) * MANIFEST_HashSize);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (-1);
+  }
+
+  hash = 0;
+  for (k = 0; k < n; k++)
+  {
+    memcpy(&stored, record + (k + 1) * MANIFEST_HashSize, MANIFEST_HashSize);
+    hash ^= mix(k, stored);
+  }
+  memcpy(&stored, record, MANIFEST_HashSize);
+  if (hash != stored)
+    return (MANIFEST_RecordError);
+
+  for (k = 0; k < n; k++)
+  {
+    page = group * _group_pages + k;
+    hash = _ep.checksum(_address + page * _page_size, _page_size);
+    if (_ep.getError() != EEPROM_NoError)
+    {
+      _errnum = _ep.getError();
+      return (-1);
+    }
+    memcpy(&stored, record + (k + 1) * MANIFEST_HashSize, MANIFEST_HashSize);
+    if (hash != stored)
+      return (page);
+  }
+
+  return (-1);
+}
+
+/**
+ * int32_t verifySample(uint32_t groups)
+ *
+ * Check the root then some groups picked at random
+ * @param groups number of groups to check (uint32_t)
+ * @return index of the first page that differs, -1 if none, MANIFEST_RootError if the root does not match, MANIFEST_RecordError if a group record is not consistent (int32_t)
+ */
+int32_t IntegrityManifest::verifySample(uint32_t groups)
+{
+  uint32_t i;
+  int32_t page;
+
+  if (!verifyRoot())
+    return (_errnum ? -1 : MANIFEST_RootError);
+
+  if (!_random)
+    _random = us_ticker_read() | 1;
+
+  for (i = 0; i < groups; i++)
+  {
+    // xorshift32
+    _random ^= _random << 13;
+    _random ^= _random >> 17;
+    _random ^= _random << 5;
+
+    page = verifyGroup(_random % _groups);
+    if (page != -1 || _errnum)
+      return (page);
+  }
+
+  return (-1);
+}
+
+/**
+ * int32_t verifyAll(void)
+ *
+ * Check the root then all the groups
+ * @param none
+ * @return index of the first page that differs, -1 if none, MANIFEST_RootError if the root does not match, MANIFEST_RecordError if a group record is not consistent (int32_t)
+ */
+int32_t IntegrityManifest::verifyAll(void)
+{
+  uint32_t g;
+  int32_t page;
+
+  if (!verifyRoot())
+    return (_errnum ? -1 : MANIFEST_RootError);
+
+  for (g = 0; g < _groups; g++)
+  {
+    page = verifyGroup(g);
+    if (page != -1 || _errnum)
+      return (page);
+  }
+
+  return (-1);
+}
+
+/**
+ * uint32_t getManifestSize(void)
+ *
+ * Get the manifest size, from its address given to the constructor
+ * @param none
+ * @return size in bytes (uint32_t)
+ */
+uint32_t IntegrityManifest::getManifestSize(void)
+{
+  return (_manifest_size);
+}
+
+/**
+ * uint8_t getError(void)
+ *
+ * Get the current error number (EEPROM_NoError if no error), a verify mismatch is not an error
+ * @param none
+ * @return none
+ */
+uint8_t IntegrityManifest::getError(void)
+{
+  return (_errnum);
+}
+
+/**
+ * bool readWord(uint32_t address, uint32_t &value)
+ *
+ * Read a hash
+ * @param address hash address (uint32_t)
+ * @param value hash (uint32_t&)
+ * @return true if read, overwise false (bool)
+ */
+bool IntegrityManifest::readWord(uint32_t address, uint32_t &value)
+{
+  _ep.read(address, (int8_t *)&value, MANIFEST_HashSize);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  return (true);
+}
+
+/**
+ * bool writeWord(uint32_t address, uint32_t value)
+ *
+ * Write a hash
+ * @param address hash address (uint32_t)
+ * @param value hash (uint32_t)
+ * @return true if written, overwise false (bool)
+ */
+bool IntegrityManifest::writeWord(uint32_t address, uint32_t value)
+{
+  _ep.write(address, (int8_t *)&value, MANIFEST_HashSize);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  return (true);
+}
+
+/**
+ * uint16_t groupPages(uint32_t group)
+ *
+ * Number of pages of a group, the last group may be shorter
+ * @param group group index (uint32_t)
+ * @return number of pages (uint16_t)
+ */
+uint16_t IntegrityManifest::groupPages(uint32_t group)
+{
+  uint32_t left = _pages - group * _group_pages;
+
+  return ((left < _group_pages) ? left : _group_pages);
+}
+
+/**
+ * uint32_t mix(uint32_t index, uint32_t hash)
+ *
+ * Hash of an (index, hash) pair (FNV-1a), XORed in the group and root hashes
+ * so that a hash change is applied without reading the other ones
+ * @param index page or group index (uint32_t)
+ * @param hash page or group hash (uint32_t)
+ * @return hash (uint32_t)
+ */
+uint32_t IntegrityManifest::mix(uint32_t index, uint32_t hash)
+{
+  uint32_t h = 0x811C9DC5;
+  uint8_t i;
+
+  for (i = 0; i < 32; i += 8)
+    h = (h ^ ((index >> i) & 0xFF)) * 0x01000193;
+  for (i = 0; i < 32; i += 8)
+    h = (h ^ ((hash >> i) & 0xFF)) * 0x01000193;
+
+  return (h);
+}
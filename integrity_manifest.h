@@ -0,0 +1,159 @@
+#ifndef __INTEGRITY_MANIFEST__H_
+#define __INTEGRITY_MANIFEST__H_
+
+/***********************************************************
+Integrity manifest of an EEPROM region : a two level hash tree.
+
+Each page of the region has a CRC-32 (EEPROM::checksum), the pages are
+grouped and each group has a hash of its page CRCs, the root is a hash
+of the group hashes. Group and root hashes are the XOR of a mix of each
+(index, hash) pair, so a page update changes them without reading the
+other pages : a write through the manifest costs one page read (new
+CRC), one record read and two small programs (group record and root).
+
+At boot, verifyRoot() reads the group hashes only (4 bytes per group),
+verifyGroup() checks the pages of a group and gives the exact page that
+differs (MANIFEST_RecordError if the group record itself is corrupted),
+verifySample() checks the root and some random groups.
+
+Manifest layout (little endian) :
+  - root hash (uint32_t), padded to the record size
+  - per group, records of a power of 2 size :
+      group hash (uint32_t)
+      CRC-32 of each page of the group (uint32_t)
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom.h"
+#include "integrity_manifest.h"
+
+EEPROM ep(p9,p10,0,EEPROM::M24M02);
+IntegrityManifest manifest(ep,0,0x3F000,0x3F000,15);   // 15 pages per group, manifest at the end
+
+int main()
+{
+  int32_t page;
+
+  page = manifest.verifySample(4);
+  if(page >= 0)
+    printf("page %d corrupted\n",page);
+
+  manifest.write(0x100,(void *)"config",7);
+
+  return(0);
+}
+*/
+
+// Defines
+#define MANIFEST_HashSize 4
+#define MANIFEST_MaxRecord 256
+#define MANIFEST_RootError -2
+#define MANIFEST_RecordError -3
+
+/** IntegrityManifest Class
+ */
+class IntegrityManifest
+{
+public:
+  /**
+   * Constructor, no access is done to the eeprom
+   * @param ep eeprom holding the region (EEPROM&)
+   * @param address start address of the region, page aligned (uint32_t)
+   * @param size region size in bytes, multiple of the page size (uint32_t)
+   * @param manifest address of the manifest, outside the region, aligned up to the record size (uint32_t)
+   * @param group_pages pages per group, up to MANIFEST_MaxRecord / MANIFEST_HashSize - 1 (uint16_t)
+   * @return none
+   */
+  IntegrityManifest(EEPROM &ep, uint32_t address, uint32_t size, uint32_t manifest, uint16_t group_pages = 1);
+
+  /**
+   * Compute and write the whole manifest from the region content
+   * @param none
+   * @return none
+   */
+  void rebuild(void);
+
+  /**
+   * Write in the region and update the manifest
+   * @param address start address (uint32_t)
+   * @param data data to write (void *)
+   * @param size number of bytes to write (uint32_t)
+   * @return none
+   */
+  void write(uint32_t address, void *data, uint32_t size);
+
+  /**
+   * Update the manifest after a write done directly on the eeprom
+   * @param address start address of the write (uint32_t)
+   * @param size number of bytes written (uint32_t)
+   * @return none
+   */
+  void update(uint32_t address, uint32_t size);
+
+  /**
+   * Check the root hash against the group hashes
+   * @param none
+   * @return true if the manifest is consistent, overwise false (bool)
+   */
+  bool verifyRoot(void);
+
+  /**
+   * Check the pages of a group against the manifest
+   * @param group group index (uint32_t)
+   * @return index in the region of the first page that differs, -1 if none, MANIFEST_RecordError if the group record is not consistent (int32_t)
+   */
+  int32_t verifyGroup(uint32_t group);
+
+  /**
+   * Check the root then some random groups
+   * @param groups number of groups to check (uint32_t)
+   * @return index of the first page that differs, -1 if none, MANIFEST_RootError if the root does not match, MANIFEST_RecordError if a group record is not consistent (int32_t)
+   */
+  int32_t verifySample(uint32_t groups);
+
+  /**
+   * Check the root then all the groups
+   * @param none
+   * @return index of the first page that differs, -1 if none, MANIFEST_RootError if the root does not match, MANIFEST_RecordError if a group record is not consistent (int32_t)
+   */
+  int32_t verifyAll(void);
+
+  /**
+   * Get the manifest size, from its address given to the constructor
+   * @param none
+   * @return size in bytes (uint32_t)
+   */
+  uint32_t getManifestSize(void);
+
+  /**
+   * Get the current error number (EEPROM_NoError if no error), a verify mismatch is not an error
+   * @param  none
+   * @return none
+   */
+  uint8_t getError(void);
+
+  //---------- local variables ----------
+private:
+  EEPROM &_ep;                                      // EEPROM holding the region
+  uint32_t _address;                                // Region start address
+  uint32_t _pages;                                  // Number of pages in the region
+  uint32_t _manifest;                               // Manifest address
+  uint32_t _groups;                                 // Number of groups
+  uint32_t _record;                                 // Group record size in bytes
+  uint32_t _manifest_size;                          // Manifest size, alignment included
+  uint16_t _page_size;                              // Page size in bytes
+  uint16_t _group_pages;                            // Pages per group
+  uint32_t _random;                                 // Sample generator state
+  uint8_t _errnum;                                  // Error number
+  bool readWord(uint32_t address, uint32_t &value); // Read a hash
+  bool writeWord(uint32_t address, uint32_t value); // Write a hash
+  uint16_t groupPages(uint32_t group);              // Number of pages of a group
+  static uint32_t mix(uint32_t index, uint32_t hash); // Hash of an (index, hash) pair
+  //-------------------------------------
+};
+#endif
@@ -0,0 +1,625 @@
+/***********************************************************
+Named partition table with per-partition I/O policies.
+************************************************************/
+#include "partition_table.h"
+
+/**
+ * PartitionTable(EEPROM &ep)
+ *
+ * Constructor, no access is done to the eeprom (see mount)
+ * @param ep eeprom holding the table (EEPROM&)
+ * @return none
+ */
+PartitionTable::PartitionTable(EEPROM &ep) : _ep(ep)
+{
+  uint8_t i;
+
+  _errnum = EEPROM_NoError;
+  _page_size = ep.getPageSize();
+  _mounted = false;
+  _count = 0;
+  _use = 0;
+  for (i = 0; i < PARTITION_CachePages; i++)
+    _cache[i].valid = false;
+}
+
+/**
+ * void format(const Partition *partitions, uint8_t count)
+ *
+ * Write a new table in the copy not holding the current table, the partitions must be page aligned,
+ * after the table pages and must not overlap. The write-back pages are synced first, nothing is
+ * written if that fails. A reset during the write leaves the previous table current
+ * @param partitions partitions (const Partition *)
+ * @param count number of partitions, up to PARTITION_Max (uint8_t)
+ * @return none
+ */
+void PartitionTable::format(const Partition *partitions, uint8_t count)
+{
+  uint8_t table[PARTITION_TableSize];
+  uint8_t *entry;
+  uint8_t i, j, seq;
+  int8_t current;
+
+  _errnum = EEPROM_NoError;
+
+  // Check parameters
+  if (count > PARTITION_Max || (count && partitions == NULL))
+  {
+    _errnum = EEPROM_ParamError;
+    return;
+  }
+
+  for (i = 0; i < count; i++)
+  {
+    if (!partitions[i].name[0] || !partitions[i].size || partitions[i].address % _page_size ||
+        partitions[i].address < tableEnd() || partitions[i].cache > PartitionWriteBack)
+    {
+      _errnum = EEPROM_ParamError;
+      return;
+    }
+    if (partitions[i].address + partitions[i].size > _ep.getSize())
+    {
+      _errnum = EEPROM_OutOfRange;
+      return;
+    }
+    for (j = 0; j < i; j++)
+    {
+      if (partitions[i].address < partitions[j].address + partitions[j].size &&
+          partitions[j].address < partitions[i].address + partitions[i].size)
+      {
+        _errnum = EEPROM_ParamError;
+        return;
+      }
+    }
+  }
+
+  // The write-back pages belong to the current table
+  sync();
+  if (_errnum)
+    return;
+
+  // The new table goes to the other copy, with the next sequence number
+  current = newestTable(table);
+  if (_errnum)
+    return;
+  seq = (current < 0) ? 0 : table[4] + 1;
+
+  memset(table, 0, sizeof(table));
+  table[0] = 'P';
+  table[1] = 'T';
+  table[2] = 2;
+  table[3] = count;
+  table[4] = seq;
+  for (i = 0; i < count; i++)
+  {
+    entry = table + PARTITION_HeaderSize + i * PARTITION_EntrySize;
+    strncpy((char *)entry, partitions[i].name, PARTITION_NameSize);
+    memcpy(entry + 8, &partitions[i].address, 4);
+    memcpy(entry + 12, &partitions[i].size, 4);
+    entry[16] = partitions[i].cache | (partitions[i].wear ? 0x04 : 0) | (partitions[i].verify ? 0x08 : 0);
+    entry[17] = partitions[i].priority;
+  }
+  table[PARTITION_HeaderSize + count * PARTITION_EntrySize] = SlotRing::crc8(table, PARTITION_HeaderSize + count * PARTITION_EntrySize);
+
+  _ep.write(tableCopy(current == 0 ? 1 : 0), (int8_t *)table, PARTITION_HeaderSize + count * PARTITION_EntrySize + 1);
+  if (_ep.getError() != EEPROM_NoError)
+    _errnum = _ep.getError();
+
+  // The cached pages may belong to the old partitions
+  for (i = 0; i < PARTITION_CachePages; i++)
+    _cache[i].valid = false;
+  _mounted = false;
+  _count = 0;
+}
+
+/**
+ * void mount(void)
+ *
+ * Load the newest valid copy of the table in RAM. The write-back pages are synced
+ * first, the table is not loaded if that fails
+ * @param none
+ * @return none
+ */
+void PartitionTable::mount(void)
+{
+  uint8_t table[PARTITION_TableSize];
+  uint8_t *entry;
+  uint8_t i;
+
+  _errnum = EEPROM_NoError;
+
+  // The write-back pages belong to the table loaded
+  sync();
+  if (_errnum)
+    return;
+
+  _mounted = true;
+  _count = 0;
+  for (i = 0; i < PARTITION_CachePages; i++)
+    _cache[i].valid = false;
+
+  // Blank or unknown table
+  if (newestTable(table) < 0)
+  {
+    if (!_errnum)
+      _errnum = EEPROM_ParamError;
+    return;
+  }
+
+  for (i = 0; i < table[3]; i++)
+  {
+    entry = table + PARTITION_HeaderSize + i * PARTITION_EntrySize;
+    memset(_parts[i].name, 0, sizeof(_parts[i].name));
+    memcpy(_parts[i].name, entry, PARTITION_NameSize);
+    memcpy(&_parts[i].address, entry + 8, 4);
+    memcpy(&_parts[i].size, entry + 12, 4);
+    _parts[i].cache = entry[16] & 0x03;
+    _parts[i].wear = (entry[16] & 0x04) != 0;
+    _parts[i].verify = (entry[16] & 0x08) != 0;
+    _parts[i].priority = entry[17];
+  }
+  _count = table[3];
+}
+
+/**
+ * int find(const char *name)
+ *
+ * Find a partition by name
+ * @param name partition name (const char *)
+ * @return partition index, -1 if not found (int)
+ */
+int PartitionTable::find(const char *name)
+{
+  uint8_t i;
+
+  if (!_mounted)
+    mount();
+
+  for (i = 0; i < _count; i++)
+  {
+    if (!strncmp(_parts[i].name, name, PARTITION_NameSize) && strlen(name) <= PARTITION_NameSize)
+      return (i);
+  }
+
+  return (-1);
+}
+
+/**
+ * const Partition *getPartition(uint8_t index)
+ *
+ * Get a partition
+ * @param index partition index (uint8_t)
+ * @return partition, NULL if index out of range (const Partition *)
+ */
+const Partition *PartitionTable::getPartition(uint8_t index)
+{
+  if (!_mounted)
+    mount();
+
+  if (index >= _count)
+    return (NULL);
+
+  return (&_parts[index]);
+}
+
+/**
+ * uint8_t getCount(void)
+ *
+ * Get the number of partitions
+ * @param none
+ * @return number of partitions (uint8_t)
+ */
+uint8_t PartitionTable::getCount(void)
+{
+  if (!_mounted)
+    mount();
+
+  return (_count);
+}
+
+/**
+ * void read(uint8_t index, uint32_t offset, void *data, uint32_t size)
+ *
+ * Read from a partition, through the cache for the cached partitions
+ * @param index partition index (uint8_t)
+ * @param offset offset in the partition (uint32_t)
+ * @param data buffer for the data (void *)
+ * @param size number of bytes to read (uint32_t)
+ * @return none
+ */
+void PartitionTable::read(uint8_t index, uint32_t offset, void *data, uint32_t size)
+{
+  int8_t *out = (int8_t *)data;
+  uint32_t address, n;
+  CachePage *page;
+
+  if (!check(index, offset, size))
+    return;
+
+  address = _parts[index].address + offset;
+  if (_parts[index].cache == PartitionNoCache)
+  {
+    _ep.read(address, out, size);
+    if (_ep.getError() != EEPROM_NoError)
+      _errnum = _ep.getError();
+    return;
+  }
+
+  while (size)
+  {
+    n = _page_size - address % _page_size;
+    if (n > size)
+      n = size;
+
+    page = cached(index, address - address % _page_size, true);
+    if (page == NULL)
+      return;
+    memcpy(out, page->data + address % _page_size, n);
+
+    address += n;
+    out += n;
+    size -= n;
+  }
+}
+
+/**
+ * void write(uint8_t index, uint32_t offset, const void *data, uint32_t size)
+ *
+ * Write to a partition with its policy, page by page
+ * @param index partition index (uint8_t)
+ * @param offset offset in the partition (uint32_t)
+ * @param data data to write (const void *)
+ * @param size number of bytes to write (uint32_t)
+ * @return none
+ */
+void PartitionTable::write(uint8_t index, uint32_t offset, const void *data, uint32_t size)
+{
+  const int8_t *in = (const int8_t *)data;
+  uint32_t address, n, i, o;
+  CachePage *page;
+
+  if (!check(index, offset, size))
+    return;
+
+  address = _parts[index].address + offset;
+  while (size && !_errnum)
+  {
+    o = address % _page_size;
+    n = _page_size - o;
+    if (n > size)
+      n = size;
+
+    if (_parts[index].cache == PartitionWriteBack)
+    {
+      // Programmed on eviction or sync, the dirty range only covers the changed bytes with wear
+      page = cached(index, address - o, true);
+      if (page == NULL)
+        return;
+      for (i = o; i < o + n; i++)
+      {
+        if (page->data[i] == in[i - o] && _parts[index].wear)
+          continue;
+        page->data[i] = in[i - o];
+        if (!page->last || i < page->first)
+          page->first = i;
+        if (i + 1 > page->last)
+          page->last = i + 1;
+      }
+    }
+    else
+    {
+      // Programmed now, the cached copy of a write-through page is updated, or dropped if
+      // the program failed as the page content is then unknown
+      page = (_parts[index].cache == PartitionWriteThrough) ? cached(index, address - o, false) : NULL;
+      program(index, address, in, n, page ? page->data + o : NULL);
+      if (page && _errnum)
+        page->valid = false;
+      else if (page)
+        memcpy(page->data + o, in, n);
+    }
+
+    address += n;
+    in += n;
+    size -= n;
+  }
+}
+
+/**
+ * void sync(void)
+ *
+ * Program the write-back pages, by partition priority then oldest first
+ * @param none
+ * @return none
+ */
+void PartitionTable::sync(void)
+{
+  CachePage *page;
+  uint8_t i;
+
+  while (!_errnum)
+  {
+    page = NULL;
+    for (i = 0; i < PARTITION_CachePages; i++)
+    {
+      if (!_cache[i].valid || !_cache[i].last)
+        continue;
+      if (page == NULL || _parts[_cache[i].partition].priority < _parts[page->partition].priority ||
+          (_parts[_cache[i].partition].priority == _parts[page->partition].priority && _cache[i].used < page->used))
+        page = &_cache[i];
+    }
+    if (page == NULL)
+      return;
+
+    flush(page);
+  }
+}
+
+/**
+ * uint8_t getError(void)
+ *
+ * Get the current error number (EEPROM_NoError if no error)
+ * @param none
+ * @return none
+ */
+uint8_t PartitionTable::getError(void)
+{
+  return (_errnum);
+}
+
+/**
+ * bool check(uint8_t index, uint32_t offset, uint32_t size)
+ *
+ * Check a partition access
+ * @param index partition index (uint8_t)
+ * @param offset offset in the partition (uint32_t)
+ * @param size number of bytes (uint32_t)
+ * @return true if the access can be done, overwise false (bool)
+ */
+bool PartitionTable::check(uint8_t index, uint32_t offset, uint32_t size)
+{
+  if (!_mounted)
+    mount();
+
+  // Check error
+  if (_errnum)
+    return (false);
+
+  if (index >= _count)
+  {
+    _errnum = EEPROM_ParamError;
+    return (false);
+  }
+
+  if (offset > _parts[index].size || size > _parts[index].size - offset)
+  {
+    _errnum = EEPROM_OutOfRange;
+    return (false);
+  }
+
+  return (true);
+}
+
+/**
+ * CachePage *cached(uint8_t index, uint32_t page, bool load)
+ *
+ * Get a cached page. On a miss the page replaces the page of the partition with the
+ * highest priority value, least recently used first
+ * @param index partition index (uint8_t)
+ * @param page page address (uint32_t)
+ * @param load load the page on a miss (bool)
+ * @return cached page, NULL on a miss without load or on error (CachePage *)
+ */
+PartitionTable::CachePage *PartitionTable::cached(uint8_t index, uint32_t page, bool load)
+{
+  CachePage *victim = NULL;
+  uint8_t i;
+
+  for (i = 0; i < PARTITION_CachePages; i++)
+  {
+    if (_cache[i].valid && _cache[i].address == page)
+    {
+      _cache[i].used = ++_use;
+      return (&_cache[i]);
+    }
+  }
+
+  if (!load)
+    return (NULL);
+
+  for (i = 0; i < PARTITION_CachePages; i++)
+  {
+    if (!_cache[i].valid)
+    {
+      victim = &_cache[i];
+      break;
+    }
+    if (victim == NULL || _parts[_cache[i].partition].priority > _parts[victim->partition].priority ||
+        (_parts[_cache[i].partition].priority == _parts[victim->partition].priority && _cache[i].used < victim->used))
+      victim = &_cache[i];
+  }
+
+  if (victim->valid)
+    flush(victim);
+  if (_errnum)
+    return (NULL);
+
+  victim->valid = false;
+  _ep.read(page, victim->data, _page_size);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (NULL);
+  }
+
+  victim->valid = true;
+  victim->partition = index;
+  victim->address = page;
+  victim->first = 0;
+  victim->last = 0;
+  victim->used = ++_use;
+
+  return (victim);
+}
+
+/**
+ * void program(uint8_t index, uint32_t address, const int8_t *data, uint32_t size, const int8_t *current)
+ *
+ * Program bytes inside a page with the wear and verify policies of the partition
+ * @param index partition index (uint8_t)
+ * @param address start address (uint32_t)
+ * @param data data to program (const int8_t *)
+ * @param size number of bytes, inside one page (uint32_t)
+ * @param current current eeprom content if known, overwise NULL (const int8_t *)
+ * @return none
+ */
+void PartitionTable::program(uint8_t index, uint32_t address, const int8_t *data, uint32_t size, const int8_t *current)
+{
+  uint32_t first, last;
+
+  // Only the range of changed bytes
+  if (_parts[index].wear)
+  {
+    if (current == NULL)
+    {
+      _ep.read(address, _buffer, size);
+      if (_ep.getError() != EEPROM_NoError)
+      {
+        _errnum = _ep.getError();
+        return;
+      }
+      current = _buffer;
+    }
+
+    for (first = 0; first < size && data[first] == current[first]; first++)
+      ;
+    if (first == size)
+      return;
+    for (last = size; data[last - 1] == current[last - 1]; last--)
+      ;
+    address += first;
+    data += first;
+    size = last - first;
+  }
+
+  _ep.write(address, (int8_t *)data, size);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return;
+  }
+
+  if (_parts[index].verify)
+  {
+    first = _ep.compare(address, data, size);
+    if (first == EEPROM_CompareError)
+      _errnum = _ep.getError();
+    else if (first != size)
+      _errnum = EEPROM_VerifyError;
+  }
+}
+
+/**
+ * void flush(CachePage *page)
+ *
+ * Program the dirty bytes of a cached page, one page program
+ * @param page cached page (CachePage *)
+ * @return none
+ */
+void PartitionTable::flush(CachePage *page)
+{
+  if (!page->last)
+    return;
+
+  program(page->partition, page->address + page->first, page->data + page->first, page->last - page->first, NULL);
+  if (!_errnum)
+    page->last = 0;
+}
+
+/**
+ * uint32_t tableEnd(void)
+ *
+ * End of the table pages, first address available for the partitions
+ * @param none
+ * @return address (uint32_t)
+ */
+uint32_t PartitionTable::tableEnd(void)
+{
+  return (tableCopy(2));
+}
+
+/**
+ * uint32_t tableCopy(uint8_t copy)
+ *
+ * Address of a table copy, each copy starts on a new page
+ * @param copy copy index, 0 or 1 (uint8_t)
+ * @return address (uint32_t)
+ */
+uint32_t PartitionTable::tableCopy(uint8_t copy)
+{
+  return (copy * ((PARTITION_TableSize + _page_size - 1) / _page_size * _page_size));
+}
+
+/**
+ * bool readTable(uint8_t copy, uint8_t *table)
+ *
+ * Read a table copy and check its header and CRC
+ * @param copy copy index, 0 or 1 (uint8_t)
+ * @param table buffer of PARTITION_TableSize bytes (uint8_t *)
+ * @return true if the copy is valid, overwise false (bool)
+ */
+bool PartitionTable::readTable(uint8_t copy, uint8_t *table)
+{
+  uint32_t size;
+
+  _ep.read(tableCopy(copy), (int8_t *)table, PARTITION_HeaderSize);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  // Blank, torn or unknown table
+  if (table[0] != 'P' || table[1] != 'T' || table[2] != 2 || table[3] > PARTITION_Max)
+    return (false);
+
+  size = PARTITION_HeaderSize + table[3] * PARTITION_EntrySize;
+  _ep.read(tableCopy(copy) + PARTITION_HeaderSize, (int8_t *)table + PARTITION_HeaderSize, size - PARTITION_HeaderSize + 1);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  return (table[size] == SlotRing::crc8(table, size));
+}
+
+/**
+ * int8_t newestTable(uint8_t *table)
+ *
+ * Find the copy holding the current table : the valid copy with the newest sequence number
+ * @param table buffer of PARTITION_TableSize bytes, current table on return (uint8_t *)
+ * @return copy index, -1 if none is valid or on error (int8_t)
+ */
+int8_t PartitionTable::newestTable(uint8_t *table)
+{
+  bool valid0, valid1;
+  uint8_t seq1;
+
+  valid1 = readTable(1, table);
+  seq1 = table[4];
+  if (_errnum)
+    return (-1);
+  valid0 = readTable(0, table);
+  if (_errnum)
+    return (-1);
+
+  if (valid0 && (!valid1 || (int8_t)(table[4] - seq1) > 0))
+    return (0);
+  if (!valid1)
+    return (-1);
+
+  // Copy 1 is the newest one, read again
+  if (!readTable(1, table))
+    return (-1);
+  return (1);
+}
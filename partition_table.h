@@ -0,0 +1,230 @@
+#ifndef __PARTITION_TABLE__H_
+#define __PARTITION_TABLE__H_
+
+/***********************************************************
+Named partition table with per-partition I/O policies.
+
+The table is stored at the start of the device (header pages) and
+splits the rest in named partitions. Two copies of the table are kept,
+each on its own pages with a sequence number : format() writes the copy
+not holding the current table, so a reset during format() leaves the
+previous table in place, and mount() loads the valid copy with the
+newest sequence number in RAM. The partition reads and writes then go
+through the policy of each partition :
+  - cache : none (direct access), write-through (reads served from
+    the cached pages, writes programmed at once) or write-back (writes
+    stay in the cached page until it is evicted or sync() is called,
+    one page program for all the writes done to the page)
+  - wear : the bytes already holding the data are not programmed, a
+    write of unchanged data costs no page program
+  - verify : the programmed bytes are read back and compared
+  - priority : order of the write-back flushes, the cached pages of the
+    partitions with the lowest priority value are programmed first and
+    evicted last
+
+The cache is shared by all the partitions : PARTITION_CachePages pages
+with a LRU eviction. format() and mount() sync the write-back pages
+first, so no write is lost when the table is replaced or reloaded.
+
+Table layout (little endian), for each of the two copies :
+  - magic "PT" (2 bytes)
+  - table version 2 (uint8_t)
+  - number of partitions (uint8_t)
+  - sequence number, the newest copy is the current table (uint8_t)
+  - per partition :
+      name, NUL padded (8 bytes)
+      address (uint32_t)
+      size (uint32_t)
+      cache (bits 0-1), wear (bit 2), verify (bit 3) (uint8_t)
+      priority (uint8_t)
+      reserved (2 bytes)
+  - CRC-8 of the previous bytes (uint8_t)
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+#include "slot_ring.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom.h"
+#include "partition_table.h"
+
+EEPROM ep(p9,p10,0,EEPROM::T24C256);
+PartitionTable table(ep);
+
+const Partition layout[] = {
+    {"config", 0x0200, 0x0E00, PartitionWriteThrough, true, true, 0},
+    {"stats", 0x1000, 0x1000, PartitionWriteBack, true, false, 1},
+    {"log", 0x2000, 0x6000, PartitionNoCache, false, false, 2}};
+
+int main()
+{
+  int32_t counter;
+  int stats;
+
+  table.mount();
+  if(table.getError()) {
+    table.format(layout,3);
+    table.mount();
+  }
+
+  stats = table.find("stats");
+  table.read(stats,0,&counter,sizeof(counter));
+  counter++;
+  table.write(stats,0,&counter,sizeof(counter));
+  table.sync();
+
+  return(0);
+}
+*/
+
+// Defines
+#define PARTITION_Max 8
+#define PARTITION_NameSize 8
+#define PARTITION_EntrySize 20
+#define PARTITION_HeaderSize 5
+#define PARTITION_TableSize (PARTITION_HeaderSize + PARTITION_Max * PARTITION_EntrySize + 1)
+#ifndef PARTITION_CachePages
+#define PARTITION_CachePages 4
+#endif
+
+enum PartitionCache
+{
+  PartitionNoCache,
+  PartitionWriteThrough,
+  PartitionWriteBack
+};
+
+/** Partition of the table
+ */
+struct Partition
+{
+  char name[PARTITION_NameSize + 1]; // Partition name
+  uint32_t address;                  // Start address
+  uint32_t size;                     // Size in bytes
+  uint8_t cache;                     // Cache policy (PartitionCache)
+  bool wear;                         // Do not program unchanged bytes
+  bool verify;                       // Read back the programmed bytes
+  uint8_t priority;                  // Write-back priority, 0 first
+};
+
+/** PartitionTable Class
+ */
+class PartitionTable
+{
+public:
+  /**
+   * Constructor, no access is done to the eeprom (see mount)
+   * @param ep eeprom holding the table (EEPROM&)
+   * @return none
+   */
+  PartitionTable(EEPROM &ep);
+
+  /**
+   * Write a new table in the copy not holding the current table, the partitions must be page aligned,
+   * after the table pages and must not overlap. The write-back pages are synced first, nothing is
+   * written if that fails. The table must then be mounted
+   * @param partitions partitions (const Partition *)
+   * @param count number of partitions, up to PARTITION_Max (uint8_t)
+   * @return none
+   */
+  void format(const Partition *partitions, uint8_t count);
+
+  /**
+   * Load the newest valid copy of the table in RAM, the write-back pages are synced first
+   * and the table is not loaded if that fails
+   * @param none
+   * @return none
+   */
+  void mount(void);
+
+  /**
+   * Find a partition by name
+   * @param name partition name (const char *)
+   * @return partition index, -1 if not found (int)
+   */
+  int find(const char *name);
+
+  /**
+   * Get a partition
+   * @param index partition index (uint8_t)
+   * @return partition, NULL if index out of range (const Partition *)
+   */
+  const Partition *getPartition(uint8_t index);
+
+  /**
+   * Get the number of partitions
+   * @param none
+   * @return number of partitions (uint8_t)
+   */
+  uint8_t getCount(void);
+
+  /**
+   * Read from a partition
+   * @param index partition index (uint8_t)
+   * @param offset offset in the partition (uint32_t)
+   * @param data buffer for the data (void *)
+   * @param size number of bytes to read (uint32_t)
+   * @return none
+   */
+  void read(uint8_t index, uint32_t offset, void *data, uint32_t size);
+
+  /**
+   * Write to a partition
+   * @param index partition index (uint8_t)
+   * @param offset offset in the partition (uint32_t)
+   * @param data data to write (const void *)
+   * @param size number of bytes to write (uint32_t)
+   * @return none
+   */
+  void write(uint8_t index, uint32_t offset, const void *data, uint32_t size);
+
+  /**
+   * Program the write-back pages, by partition priority
+   * @param none
+   * @return none
+   */
+  void sync(void);
+
+  /**
+   * Get the current error number (EEPROM_NoError if no error)
+   * @param  none
+   * @return none
+   */
+  uint8_t getError(void);
+
+  //---------- local variables ----------
+private:
+  struct CachePage
+  {
+    bool valid;                        // Page loaded
+    uint8_t partition;                 // Partition index
+    uint32_t address;                  // Page address
+    uint16_t first;                    // First dirty byte
+    uint16_t last;                     // Last dirty byte + 1, 0 if clean
+    uint32_t used;                     // Last use (LRU)
+    int8_t data[MAX_PAGE_SIZE];        // Page data
+  };
+
+  EEPROM &_ep;                         // EEPROM holding the table
+  uint16_t _page_size;                 // Page size in bytes
+  uint8_t _errnum;                     // Error number
+  bool _mounted;                       // mount done
+  uint8_t _count;                      // Number of partitions
+  Partition _parts[PARTITION_Max];     // RAM copy of the table
+  CachePage _cache[PARTITION_CachePages]; // Shared page cache
+  uint32_t _use;                       // LRU clock
+  int8_t _buffer[MAX_PAGE_SIZE];       // Page buffer of the wear policy
+  bool check(uint8_t index, uint32_t offset, uint32_t size); // Check a partition access
+  CachePage *cached(uint8_t index, uint32_t page, bool load); // Cached page, loaded on a miss if load
+  void program(uint8_t index, uint32_t address, const int8_t *data, uint32_t size, const int8_t *current); // Program with the partition policy
+  void flush(CachePage *page);         // Program the dirty bytes of a cached page
+  uint32_t tableEnd(void);             // End of the table pages
+  uint32_t tableCopy(uint8_t copy);    // Address of a table copy
+  bool readTable(uint8_t copy, uint8_t *table); // Read and check a table copy
+  int8_t newestTable(uint8_t *table);  // Copy holding the current table, read in table
+  //-------------------------------------
+};
+#endif
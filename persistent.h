@@ -0,0 +1,387 @@
+#ifndef __PERSISTENT__H_
+#define __PERSISTENT__H_
+
+/***********************************************************
+Persistent variable with a RAM shadow.
+
+Persistent<T> binds a variable of a plain data type (no pointers, no
+virtual methods) to an eeprom address. The eeprom is read once, on the
+first access, then the reads are served from RAM. An assignment only
+updates RAM and marks the variable dirty if the value changed; commit()
+writes the changed bytes, one page program per page holding changed
+bytes, and process() commits at most once per interval.
+
+The variable and the eeprom copy are compared byte per byte on commit,
+so writing back an unchanged value or a value changed and restored
+costs nothing.
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom.h"
+#include "persistent.h"
+
+struct Settings
+{
+  int32_t setpoint;
+  float gain;
+};
+
+EEPROM ep(p9,p10,0,EEPROM::T24C64);
+Persistent<int32_t> runtime(ep,0x00,60000000);   // committed at most once a minute
+Persistent<Settings> settings(ep,0x20);
+
+int main()
+{
+  Settings s = settings;
+
+  while(1) {
+    runtime = runtime + 1;
+    runtime.process();
+    if(s.setpoint != settings.get().setpoint) {
+      settings = s;
+      settings.commit();
+    }
+  }
+
+  return(0);
+}
+*/
+
+/**
+ * uint32_t persistentWrite(EEPROM &ep, uint32_t address, const uint8_t *value, uint8_t *stored, uint32_t size)
+ *
+ * Write the bytes of a value that differ from its eeprom copy : for each page, one page
+ * program from the first to the last changed byte of the page. The copy is updated with
+ * the bytes written (shared by Persistent and Versioned)
+ * @param ep eeprom holding the value (EEPROM&)
+ * @param address value address (uint32_t)
+ * @param value new value (const uint8_t *)
+ * @param stored eeprom copy of the value (uint8_t *)
+ * @param size value size in bytes (uint32_t)
+ * @return number of page programs, the error is given by ep.getError (uint32_t)
+ */
+inline uint32_t persistentWrite(EEPROM &ep, uint32_t address, const uint8_t *value, uint8_t *stored, uint32_t size)
+{
+  uint32_t page = ep.getPageSize();
+  uint32_t programs = 0;
+  uint32_t i, first, last, end;
+
+  for (i = 0; i < size;)
+  {
+    if (value[i] == stored[i])
+    {
+      i++;
+      continue;
+    }
+
+    // Changed bytes up to the end of the page
+    end = page - (address + i) % page + i;
+    if (end > size)
+      end = size;
+    first = i;
+    for (last = i; i < end; i++)
+    {
+      if (value[i] != stored[i])
+        last = i;
+    }
+
+    ep.write(address + first, (int8_t *)(value + first), last - first + 1);
+    if (ep.getError() != EEPROM_NoError)
+      break;
+    memcpy(stored + first, value + first, last - first + 1);
+    programs++;
+  }
+
+  return (programs);
+}
+
+/** Persistent Class
+ */
+template <class T>
+class Persistent
+{
+public:
+  /**
+   * Constructor, no access is done to the eeprom (see get)
+   * @param ep eeprom holding the variable (EEPROM&)
+   * @param address variable address (uint32_t)
+   * @param interval minimum time between two commits done by process, in us, 0 to disable (uint32_t)
+   * @return none
+   */
+  Persistent(EEPROM &ep, uint32_t address, uint32_t interval = 0);
+
+  /**
+   * Get the value, read from the eeprom on the first access
+   * @param none
+   * @return value (const T&)
+   */
+  const T &get(void);
+
+  /**
+   * Get the value, read from the eeprom on the first access
+   * @param none
+   * @return value (const T&)
+   */
+  operator const T &(void);
+
+  /**
+   * Set the value, the eeprom is written by commit or process
+   * @param value new value (const T&)
+   * @return none
+   */
+  void set(const T &value);
+
+  /**
+   * Set the value, the eeprom is written by commit or process
+   * @param value new value (const T&)
+   * @return this variable (Persistent&)
+   */
+  Persistent &operator=(const T &value);
+
+  /**
+   * Check if the value has been changed since the last commit
+   * @param none
+   * @return true if changed, overwise false (bool)
+   */
+  bool isDirty(void);
+
+  /**
+   * Write the changed bytes, one page program per page holding changed bytes
+   * @param none
+   * @return none
+   */
+  void commit(void);
+
+  /**
+   * Commit if the value has been changed and the interval elapsed since the last commit
+   * @param none
+   * @return none
+   */
+  void process(void);
+
+  /**
+   * Get the number of page programs done by the commits
+   * @param none
+   * @return number of page programs (uint32_t)
+   */
+  uint32_t getPagePrograms(void);
+
+  /**
+   * Get the current error number (EEPROM_NoError if no error)
+   * @param  none
+   * @return none
+   */
+  uint8_t getError(void);
+
+  //---------- local variables ----------
+private:
+  EEPROM &_ep;                                      // EEPROM holding the variable
+  uint32_t _address;                                // Variable address
+  uint32_t _interval;                               // Minimum time between two process commits (us)
+  uint32_t _last_commit;                            // Last commit time (us)
+  uint32_t _programs;                               // Page programs done
+  uint8_t _errnum;                                  // Error number
+  bool _loaded;                                     // Value read from the eeprom
+  bool _dirty;                                      // Value changed since the last commit
+  T _value;                                         // RAM value
+  T _stored;                                        // Eeprom copy
+  void load(void);                                  // Read the eeprom copy
+  //-------------------------------------
+};
+
+/**
+ * Persistent(EEPROM &ep, uint32_t address, uint32_t interval)
+ *
+ * Constructor, no access is done to the eeprom (see get)
+ * @param ep eeprom holding the variable (EEPROM&)
+ * @param address variable address (uint32_t)
+ * @param interval minimum time between two commits done by process, in us, 0 to disable (uint32_t)
+ * @return none
+ */
+template <class T>
+Persistent<T>::Persistent(EEPROM &ep, uint32_t address, uint32_t interval) : _ep(ep)
+{
+  _address = address;
+  _interval = interval;
+  _last_commit = 0;
+  _programs = 0;
+  _loaded = false;
+  _dirty = false;
+  _errnum = EEPROM_NoError;
+
+  if (address + sizeof(T) > ep.getSize())
+    _errnum = EEPROM_OutOfRange;
+}
+
+/**
+ * const T &get(void)
+ *
+ * Get the value, read from the eeprom on the first access
+ * @param none
+ * @return value (const T&)
+ */
+template <class T>
+const T &Persistent<T>::get(void)
+{
+  if (!_loaded)
+    load();
+
+  return (_value);
+}
+
+/**
+ * operator const T &(void)
+ *
+ * Get the value, read from the eeprom on the first access
+ * @param none
+ * @return value (const T&)
+ */
+template <class T>
+Persistent<T>::operator const T &(void)
+{
+  return (get());
+}
+
+/**
+ * void set(const T &value)
+ *
+ * Set the value, the eeprom is written by commit or process
+ * @param value new value (const T&)
+ * @return none
+ */
+template <class T>
+void Persistent<T>::set(const T &value)
+{
+  if (!_loaded)
+    load();
+
+  if (memcmp(&_value, &value, sizeof(T)))
+  {
+    memcpy(&_value, &value, sizeof(T));
+    _dirty = true;
+  }
+}
+
+/**
+ * Persistent &operator=(const T &value)
+ *
+ * Set the value, the eeprom is written by commit or process
+ * @param value new value (const T&)
+ * @return this variable (Persistent&)
+ */
+template <class T>
+Persistent<T> &Persistent<T>::operator=(const T &value)
+{
+  set(value);
+
+  return (*this);
+}
+
+/**
+ * bool isDirty(void)
+ *
+ * Check if the value has been changed since the last commit
+ * @param none
+ * @return true if changed, overwise false (bool)
+ */
+template <class T>
+bool Persistent<T>::isDirty(void)
+{
+  return (_dirty);
+}
+
+/**
+ * void commit(void)
+ *
+ * Write the changed bytes : for each page, one page program from the first
+ * to the last changed byte of the page
+ * @param none
+ * @return none
+ */
+template <class T>
+void Persistent<T>::commit(void)
+{
+  // Check error
+  if (_errnum || !_dirty)
+    return;
+
+  _programs += persistentWrite(_ep, _address, (const uint8_t *)&_value, (uint8_t *)&_stored, sizeof(T));
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return;
+  }
+
+  _dirty = false;
+  _last_commit = us_ticker_read();
+}
+
+/**
+ * void process(void)
+ *
+ * Commit if the value has been changed and the interval elapsed since the last commit
+ * @param none
+ * @return none
+ */
+template <class T>
+void Persistent<T>::process(void)
+{
+  if (_interval && _dirty && us_ticker_read() - _last_commit >= _interval)
+    commit();
+}
+
+/**
+ * uint32_t getPagePrograms(void)
+ *
+ * Get the number of page programs done by the commits
+ * @param none
+ * @return number of page programs (uint32_t)
+ */
+template <class T>
+uint32_t Persistent<T>::getPagePrograms(void)
+{
+  return (_programs);
+}
+
+/**
+ * uint8_t getError(void)
+ *
+ * Get the current error number (EEPROM_NoError if no error)
+ * @param none
+ * @return none
+ */
+template <class T>
+uint8_t Persistent<T>::getError(void)
+{
+  return (_errnum);
+}
+
+/**
+ * void load(void)
+ *
+ * Read the eeprom copy of the variable
+ * @param none
+ * @return none
+ */
+template <class T>
+void Persistent<T>::load(void)
+{
+  _loaded = true;
+  memset(&_stored, 0, sizeof(T));
+
+  if (!_errnum)
+  {
+    _ep.read(_address, (int8_t *)&_stored, sizeof(T));
+    if (_ep.getError() != EEPROM_NoError)
+      _errnum = _ep.getError();
+  }
+
+  memcpy(&_value, &_stored, sizeof(T));
+  _last_commit = us_ticker_read();
+}
+#endif
@@ -0,0 +1,200 @@
+/***********************************************************
+Wear-leveled persistent counter stored on an EEPROM.
+************************************************************/
+#include "persistent_counter.h"
+
+/**
+ * PersistentCounter(EEPROM &ep, uint32_t address, uint32_t slots, CounterWidth width)
+ *
+ * Constructor, no access is done to the eeprom (see mount)
+ * @param ep eeprom holding the ring (EEPROM&)
+ * @param address start address of the ring, should be slot aligned (uint32_t)
+ * @param slots number of slots in the ring, from 2 to 32768 (uint32_t)
+ * @param width counter width (CounterWidth)
+ * @return none
+ */
+PersistentCounter::PersistentCounter(EEPROM &ep, uint32_t address, uint32_t slots, CounterWidth width) : _ep(ep)
+{
+  _errnum = EEPROM_NoError;
+  _address = address;
+  _slots = slots;
+  _width = width;
+  _mounted = false;
+  _newest = -1;
+  _seq = 0;
+  _value = 0;
+
+  // Sequence + value + CRC + marker, rounded to a power of 2 so that slots never straddle a page
+  if (width == Counter32)
+    _slot_size = 8;
+  else
+    _slot_size = 16;
+
+  // The sequence number must not wrap inside the ring
+  if (slots < 2 || slots > 32768)
+    _errnum = EEPROM_ParamError;
+  else if (address + slots * _slot_size > ep.getSize())
+    _errnum = EEPROM_OutOfRange;
+}
+
+/**
+ * void mount(void)
+ *
+ * Find the newest slot of the ring and load the counter value
+ * @param none
+ * @return none
+ */
+void PersistentCounter::mount(void)
+{
+  uint32_t seq;
+
+  // Check error
+  if (_errnum)
+    return;
+
+  _mounted = true;
+  _newest = -1;
+  _seq = 0;
+  _value = 0;
+
+  // Load the value of the newest slot
+  _newest = findNewest(_slots, 0xFFFF, seq);
+  if (_newest >= 0 && !readSlot(_newest, _seq, _value))
+    _newest = -1;
+}
+
+/**
+ * void increment(uint32_t step)
+ *
+ * Increment the counter and write it in the next slot
+ * @param step increment value (uint32_t)
+ * @return none
+ */
+void PersistentCounter::increment(uint32_t step)
+{
+  uint8_t slot[16];
+  uint32_t next;
+  uint16_t seq;
+  uint64_t value;
+
+  if (!_mounted)
+    mount();
+
+  // Check error
+  if (_errnum)
+    return;
+
+  next = (_newest + 1) % _slots;
+  seq = (_newest < 0) ? 0 : (uint16_t)(_seq + 1);
+  value = _value + step;
+  if (_width == Counter32)
+    value &= 0xFFFFFFFF;
+
+  memset(slot, 0, sizeof(slot));
+  memcpy(slot, &seq, 2);
+  memcpy(slot + 2, &value, _width);
+  slot[2 + _width] = crc8(slot, 2 + _width);
+  slot[3 + _width] = COUNTER_SlotMarker;
+
+  _ep.write(_address + next * _slot_size, (int8_t *)slot, _slot_size);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return;
+  }
+
+  _newest = next;
+  _seq = seq;
+  _value = value;
+}
+
+/**
+ * uint64_t getValue(void)
+ *
+ * Get the counter value
+ * @param none
+ * @return counter value (uint64_t)
+ */
+uint64_t PersistentCounter::getValue(void)
+{
+  if (!_mounted)
+    mount();
+
+  return (_value);
+}
+
+/**
+ * uint32_t getSize(void)
+ *
+ * Get the ring size in bytes
+ * @param none
+ * @return size in bytes (uint32_t)
+ */
+uint32_t PersistentCounter::getSize(void)
+{
+  return (_slots * _slot_size);
+}
+
+/**
+ * uint8_t getError(void)
+ *
+ * Get the current error number (EEPROM_NoError if no error)
+ * @param none
+ * @return none
+ */
+uint8_t PersistentCounter::getError(void)
+{
+  return (_errnum);
+}
+
+/**
+ * bool readSlot(uint32_t slot, uint16_t &seq, uint64_t &value)
+ *
+ * Read a slot and check its marker and CRC
+ * @param slot slot index (uint32_t)
+ * @param seq slot sequence number (uint16_t&)
+ * @param value slot counter value (uint64_t&)
+ * @return true if the slot is valid, overwise false (bool)
+ */
+bool PersistentCounter::readSlot(uint32_t slot, uint16_t &seq, uint64_t &value)
+{
+  uint8_t data[12];
+
+  _ep.read(_address + slot * _slot_size, (int8_t *)data, 4 + _width);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  // Blank (0x00 or 0xFF) and torn slots are rejected
+  if (data[3 + _width] != COUNTER_SlotMarker || data[2 + _width] != crc8(data, 2 + _width))
+    return (false);
+
+  seq = 0;
+  value = 0;
+  memcpy(&seq, data, 2);
+  memcpy(&value, data + 2, _width);
+
+  return (true);
+}
+
+/**
+ * bool readSeq(uint32_t slot, uint32_t &seq)
+ *
+ * Read a slot and check its marker and CRC (SlotRing)
+ * @param slot slot index (uint32_t)
+ * @param seq slot sequence number (uint32_t&)
+ * @return true if the slot is valid, overwise false (bool)
+ */
+bool PersistentCounter::readSeq(uint32_t slot, uint32_t &seq)
+{
+  uint16_t slot_seq;
+  uint64_t value;
+
+  if (!readSlot(slot, slot_seq, value))
+    return (false);
+
+  seq = slot_seq;
+  return (true);
+}
@@ -0,0 +1,119 @@
+#ifndef __PERSISTENT_COUNTER__H_
+#define __PERSISTENT_COUNTER__H_
+
+/***********************************************************
+Wear-leveled persistent counter stored on an EEPROM.
+
+The counter is kept in a ring of slots. Each increment writes the
+next slot only, so the writes are spread over the whole ring instead
+of hitting the same page. Every slot carries a sequence number and a
+CRC, the newest slot is found at mount time with a binary search over
+the ring (a few slot sized reads, see SlotRing).
+
+Slot layout (little endian) :
+  - sequence number (uint16_t)
+  - value (uint32_t or uint64_t)
+  - CRC-8 of sequence and value (uint8_t)
+  - marker 0xA5 (uint8_t)
+  - padding up to 8 (32 bits counter) or 16 bytes (64 bits counter)
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+#include "slot_ring.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom.h"
+#include "persistent_counter.h"
+
+EEPROM ep(p9,p10,0,EEPROM::T24C02);
+PersistentCounter boots(ep,0x80,16);    // 16 slots of 8 bytes at 0x80
+
+int main()
+{
+  boots.mount();
+  boots.increment();
+  printf("Boot count %llu\n",boots.getValue());
+
+  return(0);
+}
+*/
+
+// Defines
+#define COUNTER_SlotMarker 0xA5
+
+/** PersistentCounter Class
+ */
+class PersistentCounter : public SlotRing
+{
+public:
+  enum CounterWidth
+  {
+    Counter32 = 4,
+    Counter64 = 8
+  };
+
+  /**
+   * Constructor, no access is done to the eeprom (see mount)
+   * @param ep eeprom holding the ring (EEPROM&)
+   * @param address start address of the ring, should be slot aligned (uint32_t)
+   * @param slots number of slots in the ring, from 2 to 32768 (uint32_t)
+   * @param width counter width (CounterWidth)
+   * @return none
+   */
+  PersistentCounter(EEPROM &ep, uint32_t address, uint32_t slots, CounterWidth width = Counter32);
+
+  /**
+   * Find the newest slot of the ring and load the counter value
+   * @param none
+   * @return none
+   */
+  void mount(void);
+
+  /**
+   * Increment the counter and write it in the next slot
+   * @param step increment value (uint32_t)
+   * @return none
+   */
+  void increment(uint32_t step = 1);
+
+  /**
+   * Get the counter value
+   * @param none
+   * @return counter value (uint64_t)
+   */
+  uint64_t getValue(void);
+
+  /**
+   * Get the ring size in bytes
+   * @param none
+   * @return size in bytes (uint32_t)
+   */
+  uint32_t getSize(void);
+
+  /**
+   * Get the current error number (EEPROM_NoError if no error)
+   * @param  none
+   * @return none
+   */
+  uint8_t getError(void);
+
+  //---------- local variables ----------
+private:
+  EEPROM &_ep;                                      // EEPROM holding the ring
+  uint32_t _address;                                // Ring start address
+  uint32_t _slots;                                  // Number of slots
+  uint8_t _width;                                   // Counter width in bytes
+  uint8_t _slot_size;                               // Slot size in bytes
+  uint8_t _errnum;                                  // Error number
+  bool _mounted;                                    // mount done
+  int32_t _newest;                                  // Newest slot index (-1 if ring empty)
+  uint16_t _seq;                                    // Newest slot sequence number
+  uint64_t _value;                                  // Counter value
+  bool readSlot(uint32_t slot, uint16_t &seq, uint64_t &value); // Read and check a slot
+  bool readSeq(uint32_t slot, uint32_t &seq);                   // Read and check a slot (SlotRing)
+  //-------------------------------------
+};
+#endif
@@ -0,0 +1,320 @@
+/***********************************************************
+Persistent FIFO queue stored on an EEPROM.
+************************************************************/
+#include "persistent_queue.h"
+
+/**
+ * PersistentQueue(EEPROM &ep, uint32_t address, uint32_t size, uint16_t record_size, uint32_t meta_slots)
+ *
+ * Constructor, no access is done to the eeprom (see mount)
+ * @param ep eeprom holding the queue (EEPROM&)
+ * @param address start address of the region, should be page aligned (uint32_t)
+ * @param size region size in bytes (uint32_t)
+ * @param record_size maximum record size in bytes (uint16_t)
+ * @param meta_slots number of metadata slots, from 2 to 32768 (uint32_t)
+ * @return none
+ */
+PersistentQueue::PersistentQueue(EEPROM &ep, uint32_t address, uint32_t size, uint16_t record_size, uint32_t meta_slots) : _ep(ep)
+{
+  uint32_t page = ep.getPageSize();
+  uint32_t align;
+
+  _errnum = EEPROM_NoError;
+  _address = address;
+  _meta_slots = meta_slots;
+  _record_size = record_size;
+  _mounted = false;
+  _newest = -1;
+  _seq = 0;
+  _head = 0;
+  _tail = 0;
+  _capacity = 0;
+
+  // Record slot : power of 2 inside a page, whole pages overwise
+  if ((uint32_t)record_size + QUEUE_HeaderSize <= page)
+  {
+    for (_slot_size = 1; _slot_size < (uint32_t)record_size + QUEUE_HeaderSize; _slot_size <<= 1)
+      ;
+    align = _slot_size;
+  }
+  else
+  {
+    _slot_size = (record_size + QUEUE_HeaderSize + page - 1) / page * page;
+    align = page;
+  }
+
+  // Data area after the metadata ring, aligned on the record slots
+  _data = address + meta_slots * QUEUE_MetaSize;
+  _data = (_data + align - 1) / align * align;
+
+  // The sequence number must not wrap inside the ring
+  if (meta_slots < 2 || meta_slots > 32768 || record_size == 0)
+    _errnum = EEPROM_ParamError;
+  else if (address + size > ep.getSize())
+    _errnum = EEPROM_OutOfRange;
+  else if (_data + _slot_size > address + size)
+    _errnum = EEPROM_ParamError;
+  else
+    _capacity = (address + size - _data) / _slot_size;
+}
+
+/**
+ * void mount(void)
+ *
+ * Find the newest metadata slot and load the head and tail
+ * @param none
+ * @return none
+ */
+void PersistentQueue::mount(void)
+{
+  uint32_t seq;
+
+  // Check error
+  if (_errnum)
+    return;
+
+  _mounted = true;
+  _newest = -1;
+  _seq = 0;
+  _head = 0;
+  _tail = 0;
+
+  // Load the counters of the newest slot
+  _newest = findNewest(_meta_slots, 0xFFFF, seq);
+  if (_newest >= 0 && !readMeta(_newest, _seq, _head, _tail))
+    _newest = -1;
+}
+
+/**
+ * bool push(const void *data, uint16_t size)
+ *
+ * Push a record at the head of the queue
+ * @param data record data (const void *)
+ * @param size record size in bytes, up to the maximum record size (uint16_t)
+ * @return true if pushed, false if the queue is full or on error (bool)
+ */
+bool PersistentQueue::push(const void *data, uint16_t size)
+{
+  uint32_t address;
+
+  if (!_mounted)
+    mount();
+
+  // Check error
+  if (_errnum)
+    return (false);
+
+  if (size > _record_size)
+  {
+    _errnum = EEPROM_ParamError;
+    return (false);
+  }
+
+  if (_head - _tail >= _capacity)
+    return (false);
+
+  // Header and the start of the record in one page program, the rest on its own pages
+  address = _data + (_head % _capacity) * _slot_size;
+  _ep.write(address, (int8_t *)&size, QUEUE_HeaderSize, (int8_t *)data, size);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  // Record committed by the metadata
+  return (writeMeta(_head + 1, _tail));
+}
+
+/**
+ * bool peek(void *data, uint16_t &size)
+ *
+ * Read the record at the tail of the queue, the buffer must hold the maximum record size
+ * @param data record data (void *)
+ * @param size record size in bytes (uint16_t&)
+ * @return true if read, false if the queue is empty or on error (bool)
+ */
+bool PersistentQueue::peek(void *data, uint16_t &size)
+{
+  uint32_t address;
+
+  if (!_mounted)
+    mount();
+
+  // Check error
+  if (_errnum)
+    return (false);
+
+  if (_head == _tail)
+    return (false);
+
+  address = _data + (_tail % _capacity) * _slot_size;
+  size = 0;
+  _ep.read(address, (int8_t *)&size, QUEUE_HeaderSize);
+  if (_ep.getError() == EEPROM_NoError && size > _record_size)
+  {
+    _errnum = EEPROM_OutOfRange;
+    return (false);
+  }
+  if (_ep.getError() == EEPROM_NoError && size)
+    _ep.read(address + QUEUE_HeaderSize, (int8_t *)data, size);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  return (true);
+}
+
+/**
+ * bool pop(void)
+ *
+ * Remove the record at the tail of the queue, only the metadata is written
+ * @param none
+ * @return true if removed, false if the queue is empty or on error (bool)
+ */
+bool PersistentQueue::pop(void)
+{
+  if (!_mounted)
+    mount();
+
+  // Check error
+  if (_errnum)
+    return (false);
+
+  if (_head == _tail)
+    return (false);
+
+  return (writeMeta(_head, _tail + 1));
+}
+
+/**
+ * uint32_t getCount(void)
+ *
+ * Get the number of records in the queue
+ * @param none
+ * @return number of records (uint32_t)
+ */
+uint32_t PersistentQueue::getCount(void)
+{
+  if (!_mounted)
+    mount();
+
+  return (_head - _tail);
+}
+
+/**
+ * uint32_t getCapacity(void)
+ *
+ * Get the maximum number of records in the queue
+ * @param none
+ * @return number of records (uint32_t)
+ */
+uint32_t PersistentQueue::getCapacity(void)
+{
+  return (_capacity);
+}
+
+/**
+ * uint8_t getError(void)
+ *
+ * Get the current error number (EEPROM_NoError if no error)
+ * @param none
+ * @return none
+ */
+uint8_t PersistentQueue::getError(void)
+{
+  return (_errnum);
+}
+
+/**
+ * bool writeMeta(uint32_t head, uint32_t tail)
+ *
+ * Write the head and tail in the next metadata slot
+ * @param head number of records pushed (uint32_t)
+ * @param tail number of records popped (uint32_t)
+ * @return true if written, overwise false (bool)
+ */
+bool PersistentQueue::writeMeta(uint32_t head, uint32_t tail)
+{
+  uint8_t slot[QUEUE_MetaSize];
+  uint32_t next;
+  uint16_t seq;
+
+  next = (_newest + 1) % _meta_slots;
+  seq = (_newest < 0) ? 0 : (uint16_t)(_seq + 1);
+
+  memset(slot, 0, sizeof(slot));
+  memcpy(slot, &seq, 2);
+  memcpy(slot + 2, &head, 4);
+  memcpy(slot + 6, &tail, 4);
+  slot[10] = crc8(slot, 10);
+  slot[11] = QUEUE_MetaMarker;
+
+  _ep.write(_address + next * QUEUE_MetaSize, (int8_t *)slot, QUEUE_MetaSize);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  _newest = next;
+  _seq = seq;
+  _head = head;
+  _tail = tail;
+
+  return (true);
+}
+
+/**
+ * bool readMeta(uint32_t slot, uint16_t &seq, uint32_t &head, uint32_t &tail)
+ *
+ * Read a metadata slot and check its marker, CRC and counters
+ * @param slot slot index (uint32_t)
+ * @param seq slot sequence number (uint16_t&)
+ * @param head number of records pushed (uint32_t&)
+ * @param tail number of records popped (uint32_t&)
+ * @return true if the slot is valid, overwise false (bool)
+ */
+bool PersistentQueue::readMeta(uint32_t slot, uint16_t &seq, uint32_t &head, uint32_t &tail)
+{
+  uint8_t data[12];
+
+  _ep.read(_address + slot * QUEUE_MetaSize, (int8_t *)data, sizeof(data));
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  // Blank (0x00 or 0xFF) and torn slots are rejected
+  if (data[11] != QUEUE_MetaMarker || data[10] != crc8(data, 10))
+    return (false);
+
+  memcpy(&seq, data, 2);
+  memcpy(&head, data + 2, 4);
+  memcpy(&tail, data + 6, 4);
+
+  return (head - tail <= _capacity);
+}
+
+/**
+ * bool readSeq(uint32_t slot, uint32_t &seq)
+ *
+ * Read a metadata slot and check its marker, CRC and counters (SlotRing)
+ * @param slot slot index (uint32_t)
+ * @param seq slot sequence number (uint32_t&)
+ * @return true if the slot is valid, overwise false (bool)
+ */
+bool PersistentQueue::readSeq(uint32_t slot, uint32_t &seq)
+{
+  uint16_t slot_seq;
+  uint32_t head, tail;
+
+  if (!readMeta(slot, slot_seq, head, tail))
+    return (false);
+
+  seq = slot_seq;
+  return (true);
+}
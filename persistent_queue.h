@@ -0,0 +1,153 @@
+#ifndef __PERSISTENT_QUEUE__H_
+#define __PERSISTENT_QUEUE__H_
+
+/***********************************************************
+Persistent FIFO queue stored on an EEPROM.
+
+The region is split in a metadata ring followed by a data area of
+fixed size record slots. A slot size is a power of 2 when it is smaller
+than a page and a multiple of the page size overwise, so a record never
+straddles a page it does not own.
+
+The head and tail counters are not kept at a fixed address : every
+push or pop writes the next slot of the metadata ring (same scheme as
+PersistentCounter), the newest one is found at mount time with a binary
+search. A push programs the record then the metadata, a pop only
+programs the metadata : the data area is never rewritten to consume a
+record. A push or pop torn by a reset is simply lost.
+
+Record layout (little endian) :
+  - record length (uint16_t)
+  - record data
+
+Metadata slot layout (little endian) :
+  - sequence number (uint16_t)
+  - head, number of records pushed (uint32_t)
+  - tail, number of records popped (uint32_t)
+  - CRC-8 of sequence, head and tail (uint8_t)
+  - marker 0x5A (uint8_t)
+  - padding up to 16 bytes
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+#include "slot_ring.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom.h"
+#include "persistent_queue.h"
+
+EEPROM ep(p9,p10,0,EEPROM::T24C256);
+PersistentQueue uplink(ep,0x1000,0x4000,62);   // 62 bytes messages in 16 KB at 0x1000
+
+int main()
+{
+  char message[62];
+  uint16_t size;
+
+  uplink.mount();
+  uplink.push("boot",5);
+  while(uplink.peek(message,size)) {
+    // send message ...
+    uplink.pop();
+  }
+
+  return(0);
+}
+*/
+
+// Defines
+#define QUEUE_MetaMarker 0x5A
+#define QUEUE_MetaSize 16
+#define QUEUE_HeaderSize 2
+
+/** PersistentQueue Class
+ */
+class PersistentQueue : public SlotRing
+{
+public:
+  /**
+   * Constructor, no access is done to the eeprom (see mount)
+   * @param ep eeprom holding the queue (EEPROM&)
+   * @param address start address of the region, should be page aligned (uint32_t)
+   * @param size region size in bytes (uint32_t)
+   * @param record_size maximum record size in bytes (uint16_t)
+   * @param meta_slots number of metadata slots, from 2 to 32768 (uint32_t)
+   * @return none
+   */
+  PersistentQueue(EEPROM &ep, uint32_t address, uint32_t size, uint16_t record_size, uint32_t meta_slots = 16);
+
+  /**
+   * Find the newest metadata slot and load the head and tail
+   * @param none
+   * @return none
+   */
+  void mount(void);
+
+  /**
+   * Push a record at the head of the queue
+   * @param data record data (const void *)
+   * @param size record size in bytes, up to the maximum record size (uint16_t)
+   * @return true if pushed, false if the queue is full or on error (bool)
+   */
+  bool push(const void *data, uint16_t size);
+
+  /**
+   * Read the record at the tail of the queue, the buffer must hold the maximum record size
+   * @param data record data (void *)
+   * @param size record size in bytes (uint16_t&)
+   * @return true if read, false if the queue is empty or on error (bool)
+   */
+  bool peek(void *data, uint16_t &size);
+
+  /**
+   * Remove the record at the tail of the queue
+   * @param none
+   * @return true if removed, false if the queue is empty or on error (bool)
+   */
+  bool pop(void);
+
+  /**
+   * Get the number of records in the queue
+   * @param none
+   * @return number of records (uint32_t)
+   */
+  uint32_t getCount(void);
+
+  /**
+   * Get the maximum number of records in the queue
+   * @param none
+   * @return number of records (uint32_t)
+   */
+  uint32_t getCapacity(void);
+
+  /**
+   * Get the current error number (EEPROM_NoError if no error)
+   * @param  none
+   * @return none
+   */
+  uint8_t getError(void);
+
+  //---------- local variables ----------
+private:
+  EEPROM &_ep;                                      // EEPROM holding the queue
+  uint32_t _address;                                // Metadata ring start address
+  uint32_t _meta_slots;                             // Number of metadata slots
+  uint32_t _data;                                   // Data area start address
+  uint32_t _slot_size;                              // Record slot size in bytes
+  uint32_t _capacity;                               // Number of record slots
+  uint16_t _record_size;                            // Maximum record size in bytes
+  uint8_t _errnum;                                  // Error number
+  bool _mounted;                                    // mount done
+  int32_t _newest;                                  // Newest metadata slot index (-1 if ring empty)
+  uint16_t _seq;                                    // Newest metadata slot sequence number
+  uint32_t _head;                                   // Number of records pushed
+  uint32_t _tail;                                   // Number of records popped
+  bool writeMeta(uint32_t head, uint32_t tail);     // Write the next metadata slot
+  bool readMeta(uint32_t slot, uint16_t &seq, uint32_t &head, uint32_t &tail); // Read and check a metadata slot
+  bool readSeq(uint32_t slot, uint32_t &seq);       // Read and check a metadata slot (SlotRing)
+  //-------------------------------------
+};
+#endif
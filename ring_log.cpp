@@ -0,0 +1,303 @@
+/***********************************************************
+Circular log of timestamped records stored on an EEPROM.
+************************************************************/
+#include "ring_log.h"
+
+/**
+ * RingLog(EEPROM &ep, uint32_t address, uint32_t size, uint16_t record_size)
+ *
+ * Constructor, no access is done to the eeprom (see mount)
+ * @param ep eeprom holding the log (EEPROM&)
+ * @param address start address of the region (uint32_t)
+ * @param size region size in bytes (uint32_t)
+ * @param record_size record data size in bytes (uint16_t)
+ * @return none
+ */
+RingLog::RingLog(EEPROM &ep, uint32_t address, uint32_t size, uint16_t record_size) : _ep(ep)
+{
+  uint32_t page = ep.getPageSize();
+  uint32_t align;
+
+  _errnum = EEPROM_NoError;
+  _record_size = record_size;
+  _mounted = false;
+  _newest = -1;
+  _seq = 0;
+  _oldest = 0;
+  _count = 0;
+  _slots = 0;
+
+  // Slot : power of 2 inside a page, whole pages overwise
+  if ((uint32_t)record_size + RING_HeaderSize <= page)
+  {
+    for (_slot_size = 1; _slot_size < (uint32_t)record_size + RING_HeaderSize; _slot_size <<= 1)
+      ;
+    align = _slot_size;
+  }
+  else
+  {
+    _slot_size = (record_size + RING_HeaderSize + page - 1) / page * page;
+    align = page;
+  }
+  _address = (address + align - 1) / align * align;
+
+  if (address + size > ep.getSize())
+    _errnum = EEPROM_OutOfRange;
+  else if (_address + 2 * _slot_size > address + size)
+    _errnum = EEPROM_ParamError;
+  else
+    _slots = (address + size - _address) / _slot_size;
+}
+
+/**
+ * void mount(void)
+ *
+ * Find the newest and the oldest records of the ring
+ * @param none
+ * @return none
+ */
+void RingLog::mount(void)
+{
+  uint32_t seq, timestamp;
+  uint32_t k;
+  uint8_t crc;
+
+  // Check error
+  if (_errnum)
+    return;
+
+  _mounted = true;
+  _newest = -1;
+  _seq = 0;
+  _oldest = 0;
+  _count = 0;
+
+  _newest = findNewest(_slots, 0xFFFFFFFF, seq);
+  if (_newest < 0 || !readHeader(_newest, _seq, timestamp, crc))
+  {
+    _newest = -1;
+    return;
+  }
+
+  // Records of the previous pass follow the newest one (wrapping to slot 0 after the
+  // last slot), the first of them may be torn
+  _oldest = 0;
+  _count = _newest + 1;
+  for (k = 1; k <= 2; k++)
+  {
+    if (readHeader((_newest + k) % _slots, seq, timestamp, crc) && seq == _seq - _slots + k)
+    {
+      _oldest = (_newest + k) % _slots;
+      _count = _slots - k + 1;
+      break;
+    }
+    if (_errnum)
+      return;
+  }
+}
+
+/**
+ * void append(uint32_t timestamp, const void *data)
+ *
+ * Append a record, overwriting the oldest one if the log is full
+ * @param timestamp record timestamp, not lower than the last one (uint32_t)
+ * @param data record data, record_size bytes (const void *)
+ * @return none
+ */
+void RingLog::append(uint32_t timestamp, const void *data)
+{
+  uint8_t header[RING_HeaderSize];
+  uint32_t next, seq;
+
+  if (!_mounted)
+    mount();
+
+  // Check error
+  if (_errnum)
+    return;
+
+  next = (_newest + 1) % _slots;
+  seq = (_newest < 0) ? 0 : _seq + 1;
+
+  memset(header, 0, RING_HeaderSize);
+  memcpy(header, &seq, 4);
+  memcpy(header + 4, &timestamp, 4);
+  header[8] = crc8((const uint8_t *)data, _record_size);
+  header[9] = crc8(header, 9);
+  header[10] = RING_Marker;
+
+  // Header and the start of the data in one page program, the rest on its own pages
+  _ep.write(_address + next * _slot_size, (int8_t *)header, RING_HeaderSize, (int8_t *)data, _record_size);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return;
+  }
+
+  _newest = next;
+  _seq = seq;
+  if (_count < _slots)
+    _count++;
+  else
+    _oldest = (next + 1) % _slots;
+}
+
+/**
+ * bool read(uint32_t index, uint32_t &timestamp, void *data)
+ *
+ * Read a record
+ * @param index record index, 0 for the oldest record (uint32_t)
+ * @param timestamp record timestamp (uint32_t&)
+ * @param data record data, record_size bytes (void *)
+ * @return true if the record is valid, overwise false (bool)
+ */
+bool RingLog::read(uint32_t index, uint32_t &timestamp, void *data)
+{
+  uint32_t slot, seq;
+  uint8_t crc;
+
+  if (!_mounted)
+    mount();
+
+  // Check error
+  if (_errnum)
+    return (false);
+
+  if (index >= _count)
+  {
+    _errnum = EEPROM_OutOfRange;
+    return (false);
+  }
+
+  slot = (_oldest + index) % _slots;
+  if (!readHeader(slot, seq, timestamp, crc) || seq != _seq - (_count - 1 - index))
+    return (false);
+
+  _ep.read(_address + slot * _slot_size + RING_HeaderSize, (int8_t *)data, _record_size);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  return (crc8((const uint8_t *)data, _record_size) == crc);
+}
+
+/**
+ * uint32_t seek(uint32_t timestamp)
+ *
+ * Find the first record with a timestamp greater or equal to a timestamp,
+ * with a binary search reading only the record headers
+ * @param timestamp timestamp to look for (uint32_t)
+ * @return record index, the number of records if none (uint32_t)
+ */
+uint32_t RingLog::seek(uint32_t timestamp)
+{
+  uint32_t lo, hi, mid, seq, value;
+  uint8_t crc;
+
+  if (!_mounted)
+    mount();
+
+  lo = 0;
+  hi = _count;
+  while (lo < hi && !_errnum)
+  {
+    mid = (lo + hi) / 2;
+
+    // An invalid record is counted as older
+    if (readHeader((_oldest + mid) % _slots, seq, value, crc) && value >= timestamp)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+
+  return (lo);
+}
+
+/**
+ * uint32_t getCount(void)
+ *
+ * Get the number of records in the log
+ * @param none
+ * @return number of records (uint32_t)
+ */
+uint32_t RingLog::getCount(void)
+{
+  if (!_mounted)
+    mount();
+
+  return (_count);
+}
+
+/**
+ * uint32_t getCapacity(void)
+ *
+ * Get the maximum number of records in the log
+ * @param none
+ * @return number of records (uint32_t)
+ */
+uint32_t RingLog::getCapacity(void)
+{
+  return (_slots);
+}
+
+/**
+ * uint8_t getError(void)
+ *
+ * Get the current error number (EEPROM_NoError if no error)
+ * @param none
+ * @return none
+ */
+uint8_t RingLog::getError(void)
+{
+  return (_errnum);
+}
+
+/**
+ * bool readHeader(uint32_t slot, uint32_t &seq, uint32_t &timestamp, uint8_t &crc)
+ *
+ * Read a record header and check its marker and CRC
+ * @param slot slot index (uint32_t)
+ * @param seq record sequence number (uint32_t&)
+ * @param timestamp record timestamp (uint32_t&)
+ * @param crc record data CRC (uint8_t&)
+ * @return true if the header is valid, overwise false (bool)
+ */
+bool RingLog::readHeader(uint32_t slot, uint32_t &seq, uint32_t &timestamp, uint8_t &crc)
+{
+  uint8_t data[RING_HeaderSize];
+
+  _ep.read(_address + slot * _slot_size, (int8_t *)data, RING_HeaderSize);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return (false);
+  }
+
+  // Blank (0x00 or 0xFF) and torn headers are rejected
+  if (data[10] != RING_Marker || data[9] != crc8(data, 9))
+    return (false);
+
+  memcpy(&seq, data, 4);
+  memcpy(&timestamp, data + 4, 4);
+  crc = data[8];
+
+  return (true);
+}
+
+/**
+ * bool readSeq(uint32_t slot, uint32_t &seq)
+ *
+ * Read a record header and check its marker and CRC (SlotRing)
+ * @param slot slot index (uint32_t)
+ * @param seq record sequence number (uint32_t&)
+ * @return true if the header is valid, overwise false (bool)
+ */
+bool RingLog::readSeq(uint32_t slot, uint32_t &seq)
+{
+  uint32_t timestamp;
+  uint8_t crc;
+
+  return (readHeader(slot, seq, timestamp, crc));
+}
@@ -0,0 +1,146 @@
+#ifndef __RING_LOG__H_
+#define __RING_LOG__H_
+
+/***********************************************************
+Circular log of timestamped records stored on an EEPROM.
+
+Records have a fixed size and are appended in a ring of slots, the
+oldest record is overwritten when the ring is full. A slot size is a
+power of 2 when it is smaller than a page and a multiple of the page
+size overwise, so an append is a single page program for short records.
+
+Every record carries a sequence number : at mount time the newest
+record is found with a binary search over the ring (same scheme as
+PersistentCounter), and seek finds a timestamp with a binary search
+over the records, reading only the record headers. Mount and seek cost
+about log2(number of slots) header reads, whatever the log size.
+The timestamps must not decrease from one record to the next.
+
+Record layout (little endian) :
+  - sequence number (uint32_t)
+  - timestamp (uint32_t)
+  - CRC-8 of the data (uint8_t)
+  - CRC-8 of the 9 previous bytes (uint8_t)
+  - marker 0xC3 (uint8_t)
+  - reserved (uint8_t)
+  - data
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+#include "slot_ring.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom.h"
+#include "ring_log.h"
+
+EEPROM ep(p9,p10,0,EEPROM::T24C1025);
+RingLog samples(ep,0,0x20000,20);      // 20 bytes samples on the whole chip
+
+int main()
+{
+  int8_t sample[20];
+  uint32_t index, timestamp;
+
+  samples.mount();
+  samples.append(time(NULL),sample);
+
+  // Samples of the last hour
+  for(index = samples.seek(time(NULL) - 3600); index < samples.getCount(); index++)
+    samples.read(index,timestamp,sample);
+
+  return(0);
+}
+*/
+
+// Defines
+#define RING_Marker 0xC3
+#define RING_HeaderSize 12
+
+/** RingLog Class
+ */
+class RingLog : public SlotRing
+{
+public:
+  /**
+   * Constructor, no access is done to the eeprom (see mount)
+   * @param ep eeprom holding the log (EEPROM&)
+   * @param address start address of the region (uint32_t)
+   * @param size region size in bytes (uint32_t)
+   * @param record_size record data size in bytes (uint16_t)
+   * @return none
+   */
+  RingLog(EEPROM &ep, uint32_t address, uint32_t size, uint16_t record_size);
+
+  /**
+   * Find the newest and the oldest records of the ring
+   * @param none
+   * @return none
+   */
+  void mount(void);
+
+  /**
+   * Append a record, overwriting the oldest one if the log is full
+   * @param timestamp record timestamp, not lower than the last one (uint32_t)
+   * @param data record data, record_size bytes (const void *)
+   * @return none
+   */
+  void append(uint32_t timestamp, const void *data);
+
+  /**
+   * Read a record
+   * @param index record index, 0 for the oldest record (uint32_t)
+   * @param timestamp record timestamp (uint32_t&)
+   * @param data record data, record_size bytes (void *)
+   * @return true if the record is valid, overwise false (bool)
+   */
+  bool read(uint32_t index, uint32_t &timestamp, void *data);
+
+  /**
+   * Find the first record with a timestamp greater or equal to a timestamp
+   * @param timestamp timestamp to look for (uint32_t)
+   * @return record index, the number of records if none (uint32_t)
+   */
+  uint32_t seek(uint32_t timestamp);
+
+  /**
+   * Get the number of records in the log
+   * @param none
+   * @return number of records (uint32_t)
+   */
+  uint32_t getCount(void);
+
+  /**
+   * Get the maximum number of records in the log
+   * @param none
+   * @return number of records (uint32_t)
+   */
+  uint32_t getCapacity(void);
+
+  /**
+   * Get the current error number (EEPROM_NoError if no error)
+   * @param  none
+   * @return none
+   */
+  uint8_t getError(void);
+
+  //---------- local variables ----------
+private:
+  EEPROM &_ep;                                      // EEPROM holding the log
+  uint32_t _address;                                // Ring start address
+  uint32_t _slot_size;                              // Slot size in bytes
+  uint32_t _slots;                                  // Number of slots
+  uint16_t _record_size;                            // Record data size in bytes
+  uint8_t _errnum;                                  // Error number
+  bool _mounted;                                    // mount done
+  int32_t _newest;                                  // Newest slot index (-1 if log empty)
+  uint32_t _seq;                                    // Newest record sequence number
+  uint32_t _oldest;                                 // Oldest slot index
+  uint32_t _count;                                  // Number of records
+  bool readHeader(uint32_t slot, uint32_t &seq, uint32_t &timestamp, uint8_t &crc); // Read and check a record header
+  bool readSeq(uint32_t slot, uint32_t &seq);       // Read and check a record header (SlotRing)
+  //-------------------------------------
+};
+#endif
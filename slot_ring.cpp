@@ -0,0 +1,77 @@
+/***********************************************************
+Base of the wear-leveled rings of slots.
+************************************************************/
+#include "slot_ring.h"
+
+/**
+ * uint8_t crc8(const uint8_t *data, uint32_t size)
+ *
+ * CRC-8 (polynomial 0x07, initial value 0xFF)
+ * @param data data to check (const uint8_t *)
+ * @param size number of bytes (uint32_t)
+ * @return CRC (uint8_t)
+ */
+uint8_t SlotRing::crc8(const uint8_t *data, uint32_t size)
+{
+  uint8_t crc = 0xFF;
+  uint32_t i;
+  uint8_t j;
+
+  for (i = 0; i < size; i++)
+  {
+    crc ^= data[i];
+    for (j = 0; j < 8; j++)
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+  }
+
+  return (crc);
+}
+
+/**
+ * int32_t findNewest(uint32_t slots, uint32_t seq_mask, uint32_t &seq)
+ *
+ * Find the newest slot of the ring with a binary search
+ * @param slots number of slots in the ring (uint32_t)
+ * @param seq_mask mask of the sequence numbers, 0xFFFF for 16 bits numbers (uint32_t)
+ * @param seq sequence number of the newest slot (uint32_t&)
+ * @return newest slot index, -1 if the ring is empty or on error (int32_t)
+ */
+int32_t SlotRing::findNewest(uint32_t slots, uint32_t seq_mask, uint32_t &seq)
+{
+  uint32_t seq0, mid_seq;
+  uint32_t lo, hi, mid;
+
+  if (!readSeq(0, seq0))
+  {
+    if (getError())
+      return (-1);
+
+    // Blank ring or first slot torn while starting a new pass : the last slot is then the newest one
+    if (readSeq(slots - 1, seq))
+      return (slots - 1);
+    return (-1);
+  }
+
+  // Slots written in the same pass as slot 0 verify seq - index == seq0, the others
+  // are blank, torn or from the previous pass : binary search for the last one
+  lo = 0;
+  hi = slots;
+  seq = seq0;
+  while (hi - lo > 1)
+  {
+    mid = (lo + hi) / 2;
+    if (readSeq(mid, mid_seq) && ((mid_seq - mid) & seq_mask) == seq0)
+    {
+      lo = mid;
+      seq = mid_seq;
+    }
+    else
+    {
+      if (getError())
+        return (-1);
+      hi = mid;
+    }
+  }
+
+  return (lo);
+}
@@ -0,0 +1,62 @@
+#ifndef __SLOT_RING__H_
+#define __SLOT_RING__H_
+
+/***********************************************************
+Base of the wear-leveled rings of slots (PersistentCounter,
+PersistentQueue metadata, RingLog).
+
+The slots are written in turn, each one with a sequence number one
+above the previous slot. The slots written in the same pass as slot 0
+verify seq - index == seq0, the others are blank, torn or from the
+previous pass : the newest slot is found with a binary search over the
+ring (log2(slots) + 1 slot reads). A blank ring or a slot 0 torn while
+starting a new pass makes the last slot the newest one.
+
+The derived class reads and checks a slot in readSeq(), the CRC-8 of
+the slots is shared.
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+
+/** SlotRing Class
+ */
+class SlotRing
+{
+public:
+  /**
+   * CRC-8 (polynomial 0x07, initial value 0xFF)
+   * @param data data to check (const uint8_t *)
+   * @param size number of bytes (uint32_t)
+   * @return CRC (uint8_t)
+   */
+  static uint8_t crc8(const uint8_t *data, uint32_t size);
+
+  /**
+   * Get the current error number (EEPROM_NoError if no error)
+   * @param  none
+   * @return none
+   */
+  virtual uint8_t getError(void) = 0;
+
+protected:
+  /**
+   * Find the newest slot of the ring
+   * @param slots number of slots in the ring (uint32_t)
+   * @param seq_mask mask of the sequence numbers, 0xFFFF for 16 bits numbers (uint32_t)
+   * @param seq sequence number of the newest slot (uint32_t&)
+   * @return newest slot index, -1 if the ring is empty or on error (int32_t)
+   */
+  int32_t findNewest(uint32_t slots, uint32_t seq_mask, uint32_t &seq);
+
+  /**
+   * Read a slot and check it
+   * @param slot slot index (uint32_t)
+   * @param seq slot sequence number (uint32_t&)
+   * @return true if the slot is valid, overwise false, the error is given by getError (bool)
+   */
+  virtual bool readSeq(uint32_t slot, uint32_t &seq) = 0;
+
+  virtual ~SlotRing() {}
+};
+#endif
@@ -0,0 +1,132 @@
+#ifndef __SIM_MBED__H_
+#define __SIM_MBED__H_
+
+/***********************************************************
+Host-side stub of the mbed API used by the tests (see run.sh).
+
+One simulated chip (sim) answers on the I2C and SPI buses : a memory
+array with pages, a write cycle of busy_cycles polls after each page
+program, and transfer counters. tear() cuts the power during a later
+page program : only the first bytes of that program reach the array
+and the next programs are dropped until powerOn().
+************************************************************/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+typedef int PinName;
+enum { p5 = 5, p6, p7, p8, p9, p10, NC = -1 };
+
+struct SimChip {
+  std::vector<uint8_t> mem;
+  int addr_bytes = 2;
+  int block_mask = 0;
+  int block_shift = 1;
+  uint32_t page = 32;
+  int busy = 0;
+  int busy_cycles = 3;
+  uint32_t ptr = 0;
+  long writes = 0, page_programs = 0, reads = 0, probes = 0, bytes = 0;
+  int locked = 0;           // bus lock depth
+  long unlocked = 0;        // I2C repeated start or SPI select done without the bus lock
+  bool fram = false;
+  long tear_at = -1;        // page program cut by the power loss, -1 if none
+  uint32_t tear_bytes = 0;  // bytes of that program reaching the array
+  bool off = false;         // power lost, the programs are dropped
+  void setup(uint32_t size, int ab, int bm, uint32_t pg) {
+    mem.assign(size, 0xFF); addr_bytes = ab; block_mask = bm; page = pg; busy = 0; block_shift = 1; fram = false;
+    writes = page_programs = reads = probes = bytes = unlocked = 0;
+    powerOn();
+  }
+  // Cut the power during the program after the next programs, bytes of it are written
+  void tear(long programs, uint32_t bytes) { tear_at = page_programs + programs; tear_bytes = bytes; }
+  void powerOn(void) { tear_at = -1; off = false; busy = 0; }
+  // Bytes of a program reaching the array
+  uint32_t programmed(uint32_t n) {
+    if (off) return 0;
+    if (page_programs == tear_at) { off = true; return n < tear_bytes ? n : tear_bytes; }
+    return n;
+  }
+};
+extern SimChip sim;
+
+class I2C {
+public:
+  I2C(PinName, PinName) {}
+  void frequency(int) {}
+  void lock() { sim.locked++; }
+  void unlock() { sim.locked--; }
+  int write(int addr, const char *data, int len, bool repeated = false) {
+    if (repeated && !sim.locked) sim.unlocked++;
+    if (len == 0) { sim.probes++; if (sim.busy) { sim.busy--; return 1; } return 0; }
+    if (sim.busy) { sim.busy--; return 1; }
+    sim.writes++; sim.bytes += len + 1;
+    uint32_t block = (addr >> sim.block_shift) & sim.block_mask;
+    uint32_t a = 0;
+    int i;
+    for (i = 0; i < sim.addr_bytes && i < len; i++) a = (a << 8) | (uint8_t)data[i];
+    a |= block << (8 * sim.addr_bytes);
+    a %= sim.mem.size();
+    sim.ptr = a;
+    if (len > sim.addr_bytes) {
+      uint32_t n = len - sim.addr_bytes;
+      if (!sim.fram && n > sim.page) { fprintf(stderr, "SIM: page overflow %u\n", n); abort(); }
+      if (!sim.fram && (a % sim.page) + n > sim.page) { fprintf(stderr, "SIM: page wrap at %u len %u\n", a, n); abort(); }
+      uint32_t base = a - a % sim.page;
+      uint32_t m = sim.programmed(n);
+      for (uint32_t k = 0; k < m; k++) {
+        uint32_t off = sim.fram ? (a + k) % sim.mem.size() : base + (a % sim.page + k) % sim.page;
+        sim.mem[off] = (uint8_t)data[sim.addr_bytes + k];
+      }
+      sim.page_programs++;
+      if (!sim.fram) sim.busy = sim.busy_cycles;
+    }
+    return 0;
+  }
+  int read(int addr, char *data, int len, bool repeated = false) {
+    (void)addr; (void)repeated;
+    if (sim.busy) { sim.busy--; return 1; }
+    sim.reads++; sim.bytes += len + 1;
+    for (int k = 0; k < len; k++) { data[k] = sim.mem[sim.ptr]; sim.ptr = (sim.ptr + 1) % sim.mem.size(); }
+    return 0;
+  }
+};
+
+class SPI {
+public:
+  SPI(PinName, PinName, PinName) {}
+  void format(int, int = 0) {}
+  void lock() { sim.locked++; }
+  void unlock() { sim.locked--; }
+  void frequency(int) {}
+  int write(int v);
+  int write(const char *tx, int tx_len, char *rx, int rx_len) {
+    int n = tx_len > rx_len ? tx_len : rx_len;
+    for (int i = 0; i < n; i++) { int r = write(i < tx_len ? (uint8_t)tx[i] : 0); if (i < rx_len) rx[i] = r; }
+    return n;
+  }
+};
+class DigitalOut {
+public:
+  DigitalOut(PinName, int v = 0);
+  DigitalOut &operator=(int v);
+  operator int() { return _v; }
+  int _v;
+};
+class Timer {
+public:
+  void start() {}
+  void stop() {}
+  void reset() {}
+  int read_us() { return 0; }
+};
+extern uint32_t sim_us;
+inline uint32_t us_ticker_read(void) { return sim_us; }
+inline void wait_us(int us) {
+  if (us < 0) { fprintf(stderr, "SIM: negative wait %d\n", us); abort(); }
+  sim_us += us;
+}
+inline void core_util_critical_section_enter(void) {}
+inline void core_util_critical_section_exit(void) {}
+#endif
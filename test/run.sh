@@ -0,0 +1,22 @@
+#!/bin/sh
+# Host-side tests : the library is built with g++ against the mbed stub of
+# this directory (one simulated chip on the I2C and SPI buses), then each
+# test is run. Usage : test/run.sh [test_name ...], all the tests by default
+cd "$(dirname "$0")"
+OUT=${TMPDIR:-/tmp}/eeprom_test
+mkdir -p "$OUT"
+TESTS=${*:-$(ls test_*.cpp | sed 's/\.cpp$//')}
+FAILED=0
+for t in $TESTS; do
+  if ! g++ -std=c++11 -Wall -I. -I.. sim.cpp ../*.cpp "$t.cpp" -o "$OUT/$t"; then
+    echo "FAIL $t (build)"
+    FAILED=1
+  elif ! "$OUT/$t" > "$OUT/$t.out" 2>&1; then
+    echo "FAIL $t"
+    tail -5 "$OUT/$t.out"
+    FAILED=1
+  else
+    echo "ok   $t"
+  fi
+done
+exit $FAILED
@@ -0,0 +1,44 @@
+/***********************************************************
+Simulated chip of the host-side tests, SPI side.
+************************************************************/
+#include "mbed.h"
+SimChip sim;
+uint32_t sim_us = 0;
+static std::vector<uint8_t> spi_cmd;
+static bool spi_wel = false;
+static std::vector<uint8_t> spi_pending; static uint32_t spi_addr;
+int SPI::write(int v) {
+  spi_cmd.push_back((uint8_t)v);
+  uint8_t ins = spi_cmd[0];
+  int ab = sim.addr_bytes;
+  if (ins == 0x05) { if (spi_cmd.size() == 2) { sim.probes++; if (sim.busy) { sim.busy--; return 1 | (spi_wel ? 2 : 0); } return spi_wel ? 2 : 0; } return 0; }
+  if ((ins & 0xF7) == 0x03) {
+    if ((int)spi_cmd.size() == 1 + ab) { if (sim.busy) { fprintf(stderr, "SIM: read while busy\n"); abort(); } uint32_t a = ((ins >> 3) & 1); for (int i = 0; i < ab; i++) a = (a << 8) | spi_cmd[1 + i]; spi_addr = a % sim.mem.size(); sim.reads++; }
+    if ((int)spi_cmd.size() > 1 + ab) { sim.bytes++; uint8_t r = sim.mem[spi_addr]; spi_addr = (spi_addr + 1) % sim.mem.size(); return r; }
+    return 0;
+  }
+  if ((ins & 0xF7) == 0x02) {
+    if ((int)spi_cmd.size() == 1 + ab) { uint32_t a = ((ins >> 3) & 1); for (int i = 0; i < ab; i++) a = (a << 8) | spi_cmd[1 + i]; spi_addr = a % sim.mem.size(); spi_pending.clear(); }
+    if ((int)spi_cmd.size() > 1 + ab) spi_pending.push_back((uint8_t)v);
+    return 0;
+  }
+  return 0;
+}
+DigitalOut::DigitalOut(PinName, int v) : _v(v) {}
+DigitalOut &DigitalOut::operator=(int v) {
+  if (v == 0 && _v == 1) { spi_cmd.clear(); spi_pending.clear(); if (!sim.locked) sim.unlocked++; }
+  if (v == 1 && _v == 0 && !spi_cmd.empty()) {
+    uint8_t ins = spi_cmd[0];
+    if (ins == 0x06) { if (sim.busy) { fprintf(stderr, "SIM: WREN while busy\n"); abort(); } spi_wel = true; }
+    if ((ins & 0xF7) == 0x02 && !spi_pending.empty()) {
+      if (!spi_wel) { fprintf(stderr, "SIM: write without WREN\n"); abort(); }
+      if (sim.busy) { fprintf(stderr, "SIM: write while busy\n"); abort(); }
+      uint32_t base = spi_addr - spi_addr % sim.page;
+      if (spi_addr % sim.page + spi_pending.size() > sim.page) { fprintf(stderr, "SIM: spi page wrap\n"); abort(); }
+      uint32_t m = sim.programmed(spi_pending.size());
+      for (size_t k = 0; k < m; k++) sim.mem[base + (spi_addr % sim.page + k)] = spi_pending[k];
+      sim.page_programs++; sim.writes++; sim.busy = sim.busy_cycles; spi_wel = false;
+    }
+  }
+  _v = v; return *this;
+}
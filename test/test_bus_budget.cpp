@@ -0,0 +1,48 @@
+// Bus budget : byte and transaction rates, long waits, disabled budget
+#include "mbed.h"
+#include "eeprom.h"
+#include <assert.h>
+
+int main()
+{
+  static int8_t data[2000], big[4000];
+  uint32_t start, elapsed;
+  int8_t value;
+  int i;
+
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 3;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+
+  // 10000 bytes/s, burst of 100 bytes : about 2200 bytes on the bus
+  ep.setBusBudget(10000, 100);
+  start = sim_us;
+  ep.write(0, data, 2000);
+  elapsed = sim_us - start;
+  assert(elapsed > 180000 && elapsed < 400000);
+
+  // 100 transactions/s, no burst
+  ep.setBusBudget(100, 1, EEPROM::BudgetTransactions);
+  start = sim_us;
+  for (i = 0; i < 50; i++)
+    ep.read(i, value);
+  elapsed = sim_us - start;
+  assert(elapsed >= 480000 && elapsed <= 510000);
+
+  // 1 byte/s, burst of 5000 bytes : the second 4000 bytes read waits about 3006 s, more than an int of us
+  ep.setBusBudget(1, 5000);
+  ep.read(0, big, 4000);
+  start = sim_us;
+  ep.read(0, big, 4000);
+  elapsed = sim_us - start;
+  assert(elapsed >= 3000000000u && elapsed <= 3010000000u && ep.getError() == EEPROM_NoError);
+
+  // No budget : no wait
+  ep.setBusBudget(0, 0);
+  start = sim_us;
+  ep.write(0, data, 2000);
+  assert(sim_us == start && ep.getError() == EEPROM_NoError);
+
+  printf("ok\n");
+  return (0);
+}
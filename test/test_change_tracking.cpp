@@ -0,0 +1,56 @@
+// Change tracking : changed pages, incremental backup, bitmap store across reboots
+#include "mbed.h"
+#include "eeprom.h"
+#include <assert.h>
+
+int main()
+{
+  int8_t buf[50] = {0};
+  long programs;
+
+  // One simulated chip for both eeproms : the backup copies the pages on themselves
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 0;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64), backup(p9, p10, 0, EEPROM::T24C64);
+
+  // All the pages are changed when the tracking starts
+  ep.setChangeTracking(true);
+  assert(ep.getChangedPages() == 256 && ep.backupTo(backup) == 8192 && ep.getChangedPages() == 0);
+
+  // Only the changed pages are copied, one program each
+  ep.write(100, (int8_t)1);
+  ep.write(1000, buf, 50);
+  assert(ep.getChangedPages() == 3);
+  programs = sim.page_programs;
+  assert(ep.backupTo(backup) == 96 && ep.getError() == EEPROM_NoError && backup.getError() == EEPROM_NoError);
+  assert(sim.page_programs - programs == 3);
+
+  // Bitmap stored in the last page : blank store, all the pages are changed
+  ep.setChangeTracking(true, 8160);
+  assert(ep.getChangedPages() == 256 && ep.backupTo(backup) == 8192 && ep.getChangedPages() == 0);
+  ep.write(64, (int8_t)5);
+  ep.write(65, (int8_t)6);
+  assert(ep.getChangedPages() == 1);
+
+  // The changed pages are found again after a reboot, and cleared by the backup
+  {
+    EEPROM reboot(p9, p10, 0, EEPROM::T24C64);
+    reboot.setChangeTracking(true, 8160);
+    assert(reboot.getChangedPages() == 1 && reboot.backupTo(backup) == 32);
+  }
+  {
+    EEPROM reboot(p9, p10, 0, EEPROM::T24C64);
+    reboot.setChangeTracking(true, 8160);
+    assert(reboot.getChangedPages() == 0);
+  }
+
+  // Tracking not enabled, store past the device
+  EEPROM untracked(p9, p10, 0, EEPROM::T24C64);
+  assert(untracked.backupTo(backup) == 0 && untracked.getError() == EEPROM_ParamError);
+  EEPROM outside(p9, p10, 0, EEPROM::T24C64);
+  outside.setChangeTracking(true, 8170);
+  assert(outside.getError() == EEPROM_OutOfRange);
+
+  printf("ok\n");
+  return (0);
+}
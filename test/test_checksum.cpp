@@ -0,0 +1,45 @@
+// EEPROM::checksum : check values, whole device against a host CRC-32, out of range
+#include "mbed.h"
+#include "eeprom.h"
+#include <assert.h>
+
+static uint32_t crc32(const uint8_t *data, uint32_t size)
+{
+  uint32_t crc = 0xFFFFFFFF;
+  uint32_t i;
+  int j;
+
+  for (i = 0; i < size; i++)
+  {
+    crc ^= data[i];
+    for (j = 0; j < 8; j++)
+      crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+  }
+
+  return (~crc);
+}
+
+int main()
+{
+  int i;
+
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 0;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+
+  // Check values of "123456789"
+  memcpy(&sim.mem[100], "123456789", 9);
+  assert(ep.checksum(100, 9) == 0xCBF43926);
+  assert(ep.checksum(100, 9, EEPROM::ChecksumFNV1a) == 0xBB86B11C);
+
+  // Whole device and an unaligned range across pages
+  for (i = 0; i < 8192; i++)
+    sim.mem[i] = i * 13;
+  assert(ep.checksum(0, 8192) == crc32(&sim.mem[0], 8192));
+  assert(ep.checksum(30, 1000) == crc32(&sim.mem[30], 1000) && ep.getError() == EEPROM_NoError);
+
+  assert(ep.checksum(8000, 193) == 0 && ep.getError() == EEPROM_OutOfRange);
+
+  printf("ok\n");
+  return (0);
+}
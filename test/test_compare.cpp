@@ -0,0 +1,28 @@
+// EEPROM::compare : equal data, first difference, error sentinel
+#include "mbed.h"
+#include "eeprom.h"
+#include <assert.h>
+
+int main()
+{
+  uint8_t ref[1000];
+  int i;
+
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 0;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+  for (i = 0; i < 1000; i++)
+    sim.mem[300 + i] = ref[i] = i * 11;
+
+  // Unaligned range across pages
+  assert(ep.compare(300, ref, 1000) == 1000 && ep.getError() == EEPROM_NoError);
+  sim.mem[300 + 777] ^= 4;
+  assert(ep.compare(300, ref, 1000) == 777 && ep.compare(300, ref, 700) == 700);
+  assert(ep.compare(300 + 777, ref + 777, 1) == 0);
+
+  // Errors are not taken for a difference at the end of the data
+  assert(ep.compare(8100, ref, 100) == EEPROM_CompareError && ep.getError() == EEPROM_OutOfRange);
+
+  printf("ok\n");
+  return (0);
+}
@@ -0,0 +1,46 @@
+// CompressedStore : round trip of smooth, random and run data, area and buffer checks
+#include "mbed.h"
+#include "eeprom.h"
+#include "compressed_store.h"
+#include <assert.h>
+
+int main()
+{
+  static int16_t table[2048], out[2048];
+  static uint8_t rnd[3000], rnd_out[3000], run[1000], run_out[1000];
+  uint32_t n;
+  int i;
+
+  sim.setup(32768, 2, 0, 64);
+  sim.busy_cycles = 0;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C256);
+  CompressedStore store(ep);
+
+  // Calibration like table : stored in less than a third
+  for (i = 0; i < 2048; i++)
+    table[i] = (int16_t)(1000 * (i % 64) / 64 + (i / 512));
+  n = store.write(0x1000, table, sizeof(table), 0x2000);
+  assert(n && store.getError() == EEPROM_NoError && store.getRatio() > 300 && store.getStoredSize() == n);
+  assert(store.read(0x1000, out, sizeof(out)) == sizeof(table) && !memcmp(table, out, sizeof(table)));
+
+  // Random data grows slightly
+  srand(1);
+  for (i = 0; i < 3000; i++)
+    rnd[i] = rand();
+  n = store.write(0x3000, rnd, sizeof(rnd), 0x1000);
+  assert(n > sizeof(rnd) && store.read(0x3000, rnd_out, sizeof(rnd_out)) == sizeof(rnd) && !memcmp(rnd, rnd_out, sizeof(rnd)));
+
+  // Area or buffer too small
+  assert(store.write(0x3000, rnd, sizeof(rnd), 1000) == 0 && store.getError() == EEPROM_OutOfRange);
+  assert(store.read(0x1000, out, 100) == 0 && store.getError() == EEPROM_ParamError);
+
+  // Runs (overlapping matches) at an unaligned address, empty data
+  memset(run, 'a', sizeof(run));
+  run[500] = 'b';
+  assert(store.write(0x5003, run, sizeof(run), 500));
+  assert(store.read(0x5003, run_out, sizeof(run_out)) == sizeof(run) && !memcmp(run, run_out, sizeof(run)));
+  assert(store.write(0, run, 0, 100) == LZ_HeaderSize && store.read(0, run_out, 0) == 0 && store.getError() == EEPROM_NoError);
+
+  printf("ok\n");
+  return (0);
+}
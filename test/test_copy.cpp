@@ -0,0 +1,54 @@
+// EEPROM::copy : overlapping ranges in both directions, page programs, empty and out of range copies
+#include "mbed.h"
+#include "eeprom.h"
+#include <assert.h>
+
+// Copy against memmove on the same content, one program per target page
+static void check(EEPROM &ep, uint32_t source, uint32_t target, uint32_t size)
+{
+  static uint8_t ref[8192];
+  long programs;
+  int i;
+
+  for (i = 0; i < 8192; i++)
+    sim.mem[i] = ref[i] = (i * 7 + 3) ^ (i >> 8);
+  memmove(&ref[target], &ref[source], size);
+
+  programs = sim.page_programs;
+  ep.copy(source, target, size);
+  assert(ep.getError() == EEPROM_NoError && !memcmp(&sim.mem[0], ref, 8192));
+  assert(sim.page_programs - programs == (long)((target + size - 1) / 32 - target / 32 + 1));
+}
+
+int main()
+{
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 0;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+
+  check(ep, 0, 1000, 500);
+  check(ep, 5, 37, 1);
+
+  // Overlapping, target above or below the source, within a page or pages apart
+  check(ep, 100, 110, 300);
+  check(ep, 110, 100, 300);
+  check(ep, 40, 33, 64);
+  check(ep, 33, 40, 64);
+  check(ep, 33, 64, 64);
+  check(ep, 0, 4096, 4096);
+  check(ep, 0, 1, 8191);
+  check(ep, 1, 0, 8191);
+
+  // Nothing to copy, sizes past the device end or wrapping the address range
+  ep.copy(0, 0, 0);
+  ep.copy(8191, 0, 0);
+  assert(ep.getError() == EEPROM_NoError);
+  ep.copy(100, 200, 0xFFFFFFA0);
+  assert(ep.getError() == EEPROM_OutOfRange);
+  EEPROM other(p9, p10, 0, EEPROM::T24C64);
+  other.copy(8000, 0, 500);
+  assert(other.getError() == EEPROM_OutOfRange);
+
+  printf("ok\n");
+  return (0);
+}
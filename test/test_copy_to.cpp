@@ -0,0 +1,44 @@
+// EEPROM::copyTo : copy to another eeprom, page programs, empty copies, errors reported by each eeprom
+#include "mbed.h"
+#include "eeprom.h"
+#include <assert.h>
+
+int main()
+{
+  long programs;
+  int i;
+
+  // One simulated chip for both eeproms : no write cycle, the source reads must not see the target one
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 0;
+  EEPROM source(p9, p10, 0, EEPROM::T24C64), target(p9, p10, 0, EEPROM::T24C64);
+  for (i = 0; i < 4096; i++)
+    sim.mem[i] = i * 5 + 1;
+
+  programs = sim.page_programs;
+  source.copyTo(target, 10, 4100, 3000);
+  assert(source.getError() == EEPROM_NoError && target.getError() == EEPROM_NoError);
+  for (i = 0; i < 3000; i++)
+    assert(sim.mem[4100 + i] == (uint8_t)((10 + i) * 5 + 1));
+  assert(sim.page_programs - programs == (4100 + 2999) / 32 - 4100 / 32 + 1);
+
+  // Nothing to copy
+  source.copyTo(target, 0, 0, 0);
+  source.copyTo(target, 8191, 8191, 0);
+  assert(source.getError() == EEPROM_NoError && target.getError() == EEPROM_NoError);
+
+  // Source range error on the source, target range error on the target, sizes wrapping the address range
+  {
+    EEPROM wrap(p9, p10, 0, EEPROM::T24C64);
+    wrap.copyTo(target, 100, 200, 0xFFFFFFA0);
+    assert(wrap.getError() == EEPROM_OutOfRange && target.getError() == EEPROM_NoError);
+  }
+  source.copyTo(target, 8100, 0, 200);
+  assert(source.getError() == EEPROM_OutOfRange);
+  EEPROM other(p9, p10, 0, EEPROM::T24C64);
+  other.copyTo(target, 0, 8100, 200);
+  assert(target.getError() == EEPROM_OutOfRange && other.getError() == EEPROM_NoError);
+
+  printf("ok\n");
+  return (0);
+}
@@ -0,0 +1,92 @@
+// DeltaLog : samples across mounts and flushes, full log, clear, corrupted varint, unaligned area
+#include "mbed.h"
+#include "eeprom.h"
+#include "delta_log.h"
+#include <assert.h>
+
+int main()
+{
+  static int32_t v[2000];
+  int32_t x, y;
+  int i, n;
+
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 0;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+
+  // Small steps, and the largest delta once
+  srand(3);
+  x = 2000;
+  for (i = 0; i < 2000; i++)
+  {
+    x += rand() % 21 - 10;
+    v[i] = x;
+  }
+  v[100] = 0x7FFFFFFF;
+  v[101] = -0x7FFFFFFF - 1;
+
+  {
+    DeltaLog log(ep, 0x400, 0x400);
+    log.mount();
+    assert(log.getFrames() == 0);
+    for (i = 0; i < 700; i++)
+      assert(log.append(v[i]));
+    log.flush();
+    log.rewind();
+    for (n = 0; log.next(y); n++)
+      assert(y == v[n]);
+    assert(n == 700 && log.getError() == EEPROM_NoError);
+  }
+
+  // Appended after a new mount until the area is full, read by a log not mounted
+  {
+    DeltaLog log(ep, 0x400, 0x400);
+    log.mount();
+    for (i = 700; log.append(v[i]); i++)
+      ;
+    assert(log.getError() == EEPROM_NoError && log.getFrames() == 32);
+    log.flush();
+    DeltaLog all(ep, 0x400, 0x400);
+    for (n = 0; all.next(y); n++)
+      assert(y == v[n]);
+    assert(n == i);
+
+    all.clear();
+    assert(all.getFrames() == 0);
+  }
+
+  // Two flushes of the same frame
+  {
+    DeltaLog log(ep, 0x400, 0x400);
+    log.mount();
+    assert(log.getFrames() == 0 && !log.next(y));
+    log.append(5);
+    log.append(6);
+    log.flush();
+    log.append(7);
+    log.flush();
+    DeltaLog all(ep, 0x400, 0x400);
+    for (n = 0; all.next(y); n++)
+      assert(y == 5 + n);
+    assert(n == 3 && all.getFrames() == 1);
+  }
+
+  // Varint with the continuation bit on more than DELTA_MaxVarint bytes
+  {
+    DeltaLog log(ep, 0x400, 0x400);
+    log.mount();
+    memset(&sim.mem[0x400 + DELTA_HeaderSize], 0xFF, 8);
+    log.rewind();
+    assert(log.next(y) && y == 5 && !log.next(y) && log.getError() == EEPROM_OutOfRange);
+    DeltaLog corrupted(ep, 0x400, 0x400);
+    corrupted.mount();
+    assert(corrupted.getError() == EEPROM_OutOfRange);
+  }
+
+  DeltaLog bad(ep, 0x401, 0x400);
+  bad.mount();
+  assert(bad.getError() == EEPROM_ParamError);
+
+  printf("ok\n");
+  return (0);
+}
@@ -0,0 +1,78 @@
+// Device descriptor table : block addressed parts, custom descriptors, model values, invalid models
+#include "mbed.h"
+#include "eeprom.h"
+#include "eeprom_spi.h"
+#include <assert.h>
+
+int main()
+{
+  static int8_t data[4096], back[4096];
+  int8_t value;
+  int i;
+
+  for (i = 0; i < 4096; i++)
+    data[i] = i * 13 + 1;
+
+  // 24C1025 : the block bit is address bit 2 of the device address
+  sim.setup(131072, 2, 1, 128);
+  sim.block_shift = 3;
+  {
+    EEPROM ep(p9, p10, 3, EEPROM::T24C1025);
+    assert(ep.getError() == EEPROM_NoError && ep.getSize() == 131072);
+    ep.write(65536 - 100, data, 300);
+    for (i = 0; i < 300; i++)
+      assert(sim.mem[65436 + i] == (uint8_t)data[i]);
+    ep.read(65536 + 10, back, 10);
+    assert(!memcmp(back, data + 110, 10));
+    ep.read(131071, value);
+    assert(ep.getError() == EEPROM_NoError);
+    ep.read(131072, value);
+    assert(ep.getError() == EEPROM_OutOfRange);
+  }
+
+  // M24M02 : 2 block bits, 256 bytes pages
+  sim.setup(262144, 2, 3, 256);
+  {
+    EEPROM ep(p9, p10, 1, EEPROM::M24M02);
+    assert(!strcmp(ep.getName(), "M24M02") && ep.getSize() == 262144);
+    ep.write(262144 - 4096, data, 4096);
+    ep.read(262144 - 4096, back, 4096);
+    assert(!memcmp(data, back, 4096) && ep.getError() == EEPROM_NoError);
+  }
+
+  // Part described by the application
+  EEPROMDescriptor custom = {"CAT24C256", 32768, 64, 2, 0, 1, 7, 1, 5, false};
+  sim.setup(32768, 2, 0, 64);
+  {
+    EEPROM ep(p9, p10, 0, custom);
+    assert(ep.getPageSize() == 64 && ep.getSize() == 32768);
+    ep.write(60, data, 200);
+    ep.read(60, back, 200);
+    assert(!memcmp(data, back, 200));
+  }
+
+  // The I2C EEPROM models of version 1.x are still their sizes
+  assert(EEPROM::T24C256 == 32768 && EEPROM::getDescriptor(EEPROM::T24C256).size == 32768);
+  assert(EEPROM::getDescriptor(EEPROM::MB85RC16).size == 2048 && EEPROM::getDescriptor(EEPROM::M24M01).size == 131072);
+
+  // Device address out of range, SPI model on the I2C class, unknown models
+  {
+    EEPROM bad(p9, p10, 0, (EEPROM::TypeEeprom)1000);
+    assert(EEPROM::getDescriptor((EEPROM::TypeEeprom)1000).size == 0 && bad.getError() == EEPROM_ParamError);
+  }
+  {
+    EEPROMSPI bad(p5, p6, p7, p8, (EEPROM::TypeEeprom)300);
+    assert(bad.getError() == EEPROM_ParamError);
+  }
+  {
+    EEPROM bad(p9, p10, 9, EEPROM::T24C64);
+    assert(bad.getError() == EEPROM_BadAddress);
+  }
+  {
+    EEPROM bad(p9, p10, 0, EEPROM::T25LC256);
+    assert(bad.getError() == EEPROM_ParamError);
+  }
+
+  printf("ok\n");
+  return (0);
+}
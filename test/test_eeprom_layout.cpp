@@ -0,0 +1,76 @@
+// EEPROM layout : groups by update frequency, fields around fixed addresses, large tables, checks
+#include "mbed.h"
+#include "eeprom.h"
+#include "eeprom_layout.h"
+#include <assert.h>
+
+#define PAGE 32
+
+enum Field
+{
+  BootCount,
+  Setpoint,
+  Calibration,
+  Counter,
+  Big,
+  SerialNumber,
+  FieldCount
+};
+
+constexpr LayoutField fields[FieldCount] = {
+    {"boot count", 4, LAYOUT_Hot, LAYOUT_Auto},
+    {"setpoint", 4, LAYOUT_Warm, LAYOUT_Auto},
+    {"calibration", 30, LAYOUT_Cold, LAYOUT_Auto},
+    {"counter", 30, LAYOUT_Hot, LAYOUT_Auto},
+    {"big", 70, LAYOUT_Cold, LAYOUT_Auto},
+    {"serial number", 16, LAYOUT_Cold, 0x1FF0}};
+
+EEPROM_LAYOUT_CHECK(fields, PAGE, 8192, 0);
+static_assert(layoutAddress(fields, BootCount, PAGE, 0) == 0, "hot group first");
+static_assert(layoutAddress(fields, Counter, PAGE, 0) == 32, "field moved to the next page");
+static_assert(layoutAddress(fields, Setpoint, PAGE, 0) == 64, "warm group on a new page");
+static_assert(layoutAddress(fields, Calibration, PAGE, 0) == 96, "cold group on a new page");
+static_assert(layoutAddress(fields, Big, PAGE, 0) == 128, "large field page aligned");
+static_assert(layoutEnd(fields, PAGE, 0) == 0x2000, "end after the fixed field");
+static_assert(layoutAddress(fields, BootCount, PAGE, 0x100) == 0x100, "base address");
+
+// Automatic fields placed around the fixed ones
+constexpr LayoutField around[4] = {
+    {"a", 8, 0, LAYOUT_Auto},
+    {"b", 8, 0, 4},
+    {"c", 20, 0, LAYOUT_Auto},
+    {"d", 40, 0, 32}};
+
+EEPROM_LAYOUT_CHECK(around, PAGE, 8192, 0);
+static_assert(layoutAddress(around, 0, PAGE, 0) == 12, "after the first fixed field");
+static_assert(layoutAddress(around, 2, PAGE, 0) == 72, "after the second fixed field");
+static_assert(layoutEnd(around, PAGE, 0) == 92, "end of the last automatic field");
+
+// 64 fields, half of them fixed : checked in a fraction of a second
+#define FIELDS4(k) {"x", 6, (k) % 3, LAYOUT_Auto}, {"y", 8, 0, 0x1000 + (k) * 8}, {"z", 40, (k) % 3, LAYOUT_Auto}, {"w", 8, 0, 0x1400 + (k) * 8}
+#define FIELDS16(k) FIELDS4(k), FIELDS4(k + 1), FIELDS4(k + 2), FIELDS4(k + 3)
+constexpr LayoutField many[64] = {FIELDS16(0), FIELDS16(4), FIELDS16(8), FIELDS16(12)};
+
+EEPROM_LAYOUT_CHECK(many, PAGE, 8192, 0);
+static_assert(layoutAddress(many, 62, PAGE, 0) < 0x1000, "automatic fields before the fixed ones");
+
+// Layouts stopped by EEPROM_LAYOUT_CHECK()
+constexpr LayoutField overlapping[2] = {{"a", 8, 0, 8}, {"b", 8, 0, 4}};
+constexpr LayoutField straddling[1] = {{"a", 8, 0, 28}};
+
+static_assert(layoutCollides(overlapping, PAGE, 0), "overlapping fixed fields");
+static_assert(layoutStraddles(straddling, PAGE, 0), "fixed field straddling a page");
+static_assert(layoutEnd(fields, PAGE, 0) > 4096, "layout overflowing a smaller device");
+
+int main()
+{
+  sim.setup(8192, 2, 0, 32);
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+
+  assert(layoutCheck(ep, PAGE, layoutEnd(fields, PAGE, 0)));
+  assert(!layoutCheck(ep, 64, 100));
+  assert(!layoutCheck(ep, PAGE, 8193));
+
+  printf("ok\n");
+  return (0);
+}
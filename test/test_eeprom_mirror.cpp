@@ -0,0 +1,63 @@
+// EEPROMMirror : one load, reads from RAM, dirty pages synced, size and page checks
+#include "mbed.h"
+#include "eeprom.h"
+#include "eeprom_mirror.h"
+#include <assert.h>
+
+int main()
+{
+  EEPROMDescriptor small_pages = EEPROM::getDescriptor(EEPROM::T24C02);
+  uint8_t b[40], same;
+  long reads, programs;
+  int i;
+
+  sim.setup(2048, 1, 7, 16);
+  sim.busy_cycles = 1;
+  for (i = 0; i < 2048; i++)
+    sim.mem[i] = i * 7;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C16);
+  EEPROMMirror mirror(ep);
+
+  mirror.load();
+  assert(mirror.getError() == EEPROM_NoError);
+  mirror.read(1000, b, 40);
+  for (i = 0; i < 40; i++)
+    assert(b[i] == (uint8_t)((1000 + i) * 7));
+  reads = sim.reads;
+  for (i = 0; i < 100; i++)
+    mirror.read(i, b, 10);
+  assert(sim.reads == reads);
+
+  // 5 pages changed, a write of the same value is not dirty
+  memset(b, 0x55, 40);
+  mirror.write(1020, b, 40);
+  mirror.write(5, b, 1);
+  same = (uint8_t)(300 * 7);
+  mirror.write(300, &same, 1);
+  assert(mirror.getDirtyPages() == 5);
+  programs = sim.page_programs;
+  reads = sim.reads;
+  mirror.sync();
+  assert(sim.page_programs - programs == 5 && sim.reads == reads && mirror.getDirtyPages() == 0);
+  for (i = 1020; i < 1060; i++)
+    assert(sim.mem[i] == 0x55);
+  assert(sim.mem[1019] == (uint8_t)(1019 * 7) && sim.mem[1060] == (uint8_t)(1060 * 7) && sim.mem[5] == 0x55);
+
+  mirror.read(2040, b, 9);
+  assert(mirror.getError() == EEPROM_OutOfRange);
+
+  // Parts larger than MIRROR_MaxSize or with pages below MIRROR_MinPage bytes
+  sim.setup(8192, 2, 0, 32);
+  EEPROM large(p9, p10, 0, EEPROM::T24C64);
+  EEPROMMirror large_mirror(large);
+  assert(large_mirror.getError() == EEPROM_ParamError);
+
+  small_pages.page_size = 4;
+  sim.setup(256, 1, 0, 4);
+  EEPROM small(p9, p10, 0, small_pages);
+  EEPROMMirror small_mirror(small);
+  assert(small.getPageSize() == 4 && small_mirror.getError() == EEPROM_ParamError);
+
+  printf("ok\n");
+  return (0);
+}
@@ -0,0 +1,65 @@
+// SPI EEPROM backend : page writes, reads, fill and the modules on top of it
+#include "mbed.h"
+#include "eeprom.h"
+#include "eeprom_spi.h"
+#include "persistent_counter.h"
+#include <assert.h>
+
+int main()
+{
+  static int8_t data[4096], back[4096];
+  int8_t value;
+  int i;
+
+  for (i = 0; i < 4096; i++)
+    data[i] = i * 13 + 1;
+
+  // 25LC040 : 1 address byte, the 9th address bit in the instruction
+  sim.setup(512, 1, 1, 16);
+  {
+    EEPROMSPI ep(p5, p6, p7, p8, EEPROM::T25LC040);
+    assert(ep.getSize() == 512);
+    ep.write(3, data, 500);
+    ep.read(3, back, 500);
+    assert(!memcmp(data, back, 500) && ep.getError() == EEPROM_NoError);
+
+    // Current address read after a random read
+    ep.read(300, value);
+    assert(value == data[297]);
+    ep.read(value);
+    assert(value == data[298]);
+
+    ep.fill(10, 0x5A, 100);
+    for (i = 0; i < 100; i++)
+      assert(sim.mem[10 + i] == 0x5A);
+    ep.clear();
+    for (i = 0; i < 512; i++)
+      assert(sim.mem[i] == 0);
+
+    PersistentCounter counter(ep, 256, 8);
+    counter.mount();
+    for (i = 0; i < 20; i++)
+      counter.increment();
+    PersistentCounter again(ep, 256, 8);
+    again.mount();
+    assert(again.getValue() == 20);
+  }
+
+  // 25LC1024 : 3 address bytes, 256 bytes pages
+  sim.setup(131072, 3, 0, 256);
+  {
+    EEPROMSPI ep(p5, p6, p7, p8, EEPROM::T25LC1024);
+    ep.write(70000, data, 4096);
+    ep.read(70000, back, 4096);
+    assert(!memcmp(data, back, 4096) && ep.getError() == EEPROM_NoError);
+  }
+
+  // An I2C model is refused by the SPI backend
+  {
+    EEPROMSPI bad(p5, p6, p7, p8, EEPROM::T24C256);
+    assert(bad.getError() == EEPROM_ParamError);
+  }
+
+  printf("ok\n");
+  return (0);
+}
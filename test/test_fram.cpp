@@ -0,0 +1,53 @@
+// FRAM devices : no write cycle polling, writes in bus frames, block addressed parts
+#include "mbed.h"
+#include "eeprom.h"
+#include <assert.h>
+
+int main()
+{
+  static int8_t data[2048], back[2048];
+  int8_t value;
+  int i;
+
+  for (i = 0; i < 2048; i++)
+    data[i] = i * 7;
+
+  // 2 KB FRAM, 1 address byte and 3 block bits : no ready() polling
+  sim.setup(2048, 1, 7, 1 << 30);
+  sim.fram = true;
+  {
+    EEPROM ep(p9, p10, 0, EEPROM::MB85RC16);
+    assert(ep.getSize() == 2048);
+    ep.write(100, data, 1900);
+    ep.read(100, back, 100);
+    assert(!memcmp(data, back, 100));
+    for (i = 0; i < 1900; i++)
+      assert(sim.mem[100 + i] == (uint8_t)data[i]);
+    assert(sim.probes == 0 && ep.getError() == EEPROM_NoError);
+  }
+
+  // One locked transaction per MAX_PAGE_SIZE frame
+  sim.setup(8192, 2, 0, 1 << 30);
+  sim.fram = true;
+  {
+    EEPROM ep(p9, p10, 0, EEPROM::MB85RC64);
+    ep.write(0, data, 2048);
+    assert(sim.writes == 2048 / MAX_PAGE_SIZE && sim.probes == 0);
+  }
+
+  // Regular EEPROM with blocks (24C16) : pages and blocks are not crossed
+  sim.setup(2048, 1, 7, 16);
+  {
+    EEPROM ep(p9, p10, 0, EEPROM::T24C16);
+    ep.write(250, data, 1000);
+    for (i = 0; i < 1000; i++)
+      assert(sim.mem[250 + i] == (uint8_t)data[i]);
+    ep.read(250, back, 6);
+    assert(!memcmp(back, data, 6));
+    ep.read(256 + 3, value);
+    assert(value == data[9] && ep.getError() == EEPROM_NoError);
+  }
+
+  printf("ok\n");
+  return (0);
+}
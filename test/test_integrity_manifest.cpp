@@ -0,0 +1,72 @@
+// IntegrityManifest : rebuild, writes through the manifest, corrupted page, group record and root
+#include "mbed.h"
+#include "eeprom.h"
+#include "integrity_manifest.h"
+#include <assert.h>
+
+int main()
+{
+  char big[600];
+  int32_t page;
+  long reads, programs;
+  int i;
+
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 0;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+  for (i = 0; i < 8192; i++)
+    sim.mem[i] = i * 7;
+
+  // 192 pages, 28 groups of 7 pages, 32 bytes records
+  IntegrityManifest manifest(ep, 0, 6144, 7168, 7);
+  assert(manifest.getError() == EEPROM_NoError && manifest.getManifestSize() == 32 + 28 * 32);
+  assert(manifest.verifyAll() == MANIFEST_RootError);
+  manifest.rebuild();
+  assert(manifest.getError() == EEPROM_NoError && manifest.verifyRoot() && manifest.verifyAll() == -1);
+
+  // Writes across pages and groups keep the manifest consistent, 2 pages of a group :
+  // 2 data programs, the group record and the root
+  programs = sim.page_programs;
+  manifest.write(100, (void *)"hello world, spanning pages!", 29);
+  assert(manifest.getError() == EEPROM_NoError && sim.page_programs - programs == 4);
+  assert(manifest.verifyAll() == -1);
+  memset(big, 0x33, sizeof(big));
+  manifest.write(200, big, sizeof(big));
+  assert(manifest.verifyAll() == -1);
+
+  // Corrupted page found by each check
+  sim.mem[57 * 32 + 3] ^= 1;
+  assert(manifest.verifyAll() == 57 && manifest.verifyGroup(57 / 7) == 57);
+  for (i = 0, page = -1; i < 50 && page < 0; i++)
+    page = manifest.verifySample(4);
+  assert(page == 57);
+  sim.mem[57 * 32 + 3] ^= 1;
+
+  // A sample reads the group hashes and 2 groups only
+  reads = sim.reads;
+  assert(manifest.verifySample(2) == -1 && sim.reads - reads < 60);
+
+  // Corrupted page CRC in the record of group 2 : told apart from a change of its first page
+  sim.mem[7168 + 32 * 3 + 8] ^= 1;
+  assert(manifest.verifyAll() == MANIFEST_RecordError && manifest.verifyGroup(2) == MANIFEST_RecordError);
+  sim.mem[14 * 32] ^= 1;
+  sim.mem[7168 + 32 * 3 + 8] ^= 1;
+  assert(manifest.verifyGroup(2) == 14);
+  sim.mem[14 * 32] ^= 1;
+
+  // Corrupted page CRC and group hash of group 2 : consistent record, the root differs
+  sim.mem[7168 + 32 * 3 + 8] ^= 1;
+  sim.mem[7168 + 32 * 3 + 1] ^= 1;
+  assert(manifest.verifyAll() == MANIFEST_RootError);
+  manifest.rebuild();
+  assert(manifest.verifyAll() == -1);
+
+  // Manifest over the region or past the device
+  IntegrityManifest over(ep, 0, 7168, 7000, 7);
+  assert(over.getError() == EEPROM_ParamError);
+  IntegrityManifest past(ep, 0, 7168, 8000, 7);
+  assert(past.getError() == EEPROM_OutOfRange);
+
+  printf("ok\n");
+  return (0);
+}
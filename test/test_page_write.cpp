@@ -0,0 +1,51 @@
+// Page writer : one locked bus transaction per page program, reads in a locked transfer
+#include "mbed.h"
+#include "eeprom.h"
+#include "eeprom_spi.h"
+#include <assert.h>
+
+int main()
+{
+  static int8_t data[1024], back[1024];
+  int i;
+
+  for (i = 0; i < 1024; i++)
+    data[i] = i * 3 + 1;
+
+  // I2C : a 1000 bytes write from offset 20 is 8 page programs, one transaction each
+  sim.setup(65536, 2, 0, 128);
+  sim.busy_cycles = 0;
+  {
+    EEPROM ep(p9, p10, 0, EEPROM::T24C512);
+    ep.write(20, data, 1000);
+    assert(sim.page_programs == 8 && sim.writes == 8);
+    ep.read(20, back, 1000);
+    assert(!memcmp(data, back, 1000));
+    assert(sim.unlocked == 0 && sim.locked == 0);
+  }
+
+  // Largest pages of MAX_PAGE_SIZE bytes
+  sim.setup(262144, 2, 3, 256);
+  sim.busy_cycles = 0;
+  {
+    EEPROM ep(p9, p10, 0, EEPROM::M24M02);
+    ep.write(250, data, 1000);
+    assert(sim.page_programs == 5 && sim.writes == 5);
+    ep.read(250, back, 1000);
+    assert(!memcmp(data, back, 1000) && ep.getError() == EEPROM_NoError);
+  }
+
+  // SPI : WREN and WRITE of a page under one bus lock, status polls and reads locked
+  sim.setup(32768, 2, 0, 64);
+  {
+    EEPROMSPI ep(p5, p6, p7, p8, EEPROM::T25LC256);
+    ep.write(10, data, 500);
+    assert(sim.page_programs == 8);
+    ep.read(10, back, 500);
+    assert(!memcmp(data, back, 500));
+    assert(sim.unlocked == 0 && sim.locked == 0);
+  }
+
+  printf("ok\n");
+  return (0);
+}
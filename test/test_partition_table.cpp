@@ -0,0 +1,154 @@
+// PartitionTable : table checks, cache policies, eviction, sync on mount and format, torn format
+#include "mbed.h"
+#include "eeprom.h"
+#include "partition_table.h"
+#include <assert.h>
+
+static const Partition layout[] = {
+    {"config", 0x0200, 0x0E00, PartitionWriteThrough, true, true, 0},
+    {"stats", 0x1000, 0x1000, PartitionWriteBack, true, false, 1},
+    {"log", 0x2000, 0x6000, PartitionNoCache, false, false, 2}};
+
+static uint32_t remount(EEPROM &ep)
+{
+  PartitionTable table(ep);
+
+  table.mount();
+  assert(table.getError() == EEPROM_NoError);
+  return (table.getCount());
+}
+
+int main()
+{
+  Partition outside[] = {{"a", 0x40, 0x100, 0, 0, 0, 0}};
+  Partition overlapping[] = {{"a", 0x200, 0x100, 0, 0, 0, 0}, {"b", 0x2C0, 0x100, 0, 0, 0, 0}};
+  Partition one[] = {{"a", 0x200, 0x100, 0, 0, 0, 0}};
+  char s[100], r[100];
+  int32_t i, v, same;
+  long programs, reads;
+  int cfg, st, lg, k;
+
+  sim.setup(32768, 2, 0, 64);
+  sim.busy_cycles = 0;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C256);
+
+  // No table yet, partitions over the tables or overlapping
+  {
+    PartitionTable table(ep);
+    table.mount();
+    assert(table.getError() == EEPROM_ParamError);
+    table.format(outside, 1);
+    assert(table.getError() == EEPROM_ParamError);
+    table.format(overlapping, 2);
+    assert(table.getError() == EEPROM_ParamError);
+    table.format(layout, 3);
+    assert(table.getError() == EEPROM_NoError);
+  }
+
+  PartitionTable table(ep);
+  table.mount();
+  assert(table.getError() == EEPROM_NoError && table.getCount() == 3);
+  cfg = table.find("config");
+  st = table.find("stats");
+  lg = table.find("log");
+  assert(cfg == 0 && st == 1 && lg == 2 && table.find("nope") == -1);
+  assert(table.getPartition(1)->cache == PartitionWriteBack && table.getPartition(0)->verify && table.getPartition(2)->address == 0x2000);
+
+  // Write-back : many writes, one program on sync, none for the same value
+  programs = sim.page_programs;
+  for (i = 0; i < 50; i++)
+    table.write(st, 8, &i, 4);
+  assert(sim.page_programs == programs);
+  table.read(st, 8, &v, 4);
+  assert(v == 49);
+  table.sync();
+  assert(sim.page_programs == programs + 1 && table.getError() == EEPROM_NoError);
+  ep.read(0x1008, v);
+  assert(v == 49);
+  programs = sim.page_programs;
+  same = 49;
+  table.write(st, 8, &same, 4);
+  table.sync();
+  assert(sim.page_programs == programs);
+
+  // Write-through with verify, no program for the same data
+  memset(s, 'x', 100);
+  programs = sim.page_programs;
+  table.write(cfg, 60, s, 100);
+  assert(sim.page_programs == programs + 3 && table.getError() == EEPROM_NoError);
+  table.write(cfg, 60, s, 100);
+  assert(sim.page_programs == programs + 3);
+  table.read(cfg, 60, r, 100);
+  assert(!memcmp(r, s, 100));
+
+  // A write-through program lost with the power is reported, the chip content is read back
+  memset(s, 'y', 10);
+  sim.tear(0, 0);
+  table.write(cfg, 60, s, 10);
+  sim.powerOn();
+  assert(table.getError() == EEPROM_VerifyError);
+  table.mount();
+  table.read(cfg, 60, r, 10);
+  assert(table.getError() == EEPROM_NoError && r[0] == 'x' && r[9] == 'x');
+  memset(s, 'x', 100);
+
+  // No cache
+  table.write(lg, 0, s, 10);
+  assert(sim.mem[0x2000] == 'x');
+  table.write(lg, 0x6000 - 2, s, 4);
+  assert(table.getError() == EEPROM_OutOfRange);
+
+  // Eviction by priority : the config page stays cached
+  PartitionTable other(ep);
+  other.mount();
+  other.read(cfg, 0, r, 1);
+  for (i = 0; i < 6; i++)
+    other.write(st, i * 64, &i, 4);
+  reads = sim.reads;
+  other.read(cfg, 0, r, 1);
+  assert(sim.reads == reads);
+  other.sync();
+  for (i = 0; i < 6; i++)
+  {
+    ep.read(0x1000 + i * 64, v);
+    assert(v == i);
+  }
+
+  // Mount and format sync the write-back pages first
+  v = 1234;
+  other.write(st, 0, &v, 4);
+  other.mount();
+  assert(other.getError() == EEPROM_NoError);
+  ep.read(0x1000, v);
+  assert(v == 1234);
+  v = 77;
+  other.write(st, 4, &v, 4);
+  assert(sim.mem[0] == 'P' && sim.mem[192] != 'P');
+  other.format(one, 1);
+  assert(other.getError() == EEPROM_NoError);
+  ep.read(0x1004, v);
+  assert(v == 77);
+
+  // The new table went to the second copy
+  assert(sim.mem[192] == 'P' && remount(ep) == 1);
+
+  // Power lost during each byte of the first copy : the second one is kept
+  for (k = 0; k < PARTITION_HeaderSize + 3 * PARTITION_EntrySize + 1; k++)
+  {
+    PartitionTable torn(ep);
+    torn.mount();
+    sim.tear(k / 64, k % 64);
+    torn.format(layout, 3);
+    sim.powerOn();
+    assert(remount(ep) == 1);
+  }
+  {
+    PartitionTable next(ep);
+    next.mount();
+    next.format(layout, 3);
+    assert(next.getError() == EEPROM_NoError && remount(ep) == 3);
+  }
+
+  printf("ok\n");
+  return (0);
+}
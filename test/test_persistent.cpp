@@ -0,0 +1,71 @@
+// Persistent : cached reads, delayed commit, changed pages only, out of range
+#include "mbed.h"
+#include "eeprom.h"
+#include "persistent.h"
+#include <assert.h>
+
+struct Settings
+{
+  int32_t a;
+  float gain;
+  uint8_t pad[40];
+};
+
+int main()
+{
+  Settings x;
+  int32_t v, check;
+  long reads, programs;
+  int i;
+
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 0;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+  ep.write(0x10, (int32_t)41);
+
+  // One read for all the gets
+  Persistent<int32_t> counter(ep, 0x10, 1000);
+  reads = sim.reads;
+  v = counter;
+  assert(v == 41);
+  for (i = 0; i < 10; i++)
+    v = counter;
+  assert(sim.reads - reads == 1);
+
+  // Committed by process() once the delay is over, the same value is not dirty
+  programs = sim.page_programs;
+  counter = counter + 1;
+  counter.process();
+  assert(sim.page_programs == programs);
+  sim_us += 1000;
+  counter.process();
+  assert(sim.page_programs == programs + 1 && !counter.isDirty());
+  ep.read(0x10, check);
+  assert(check == 42);
+  counter = 42;
+  assert(!counter.isDirty());
+
+  // Value across 3 pages : only the changed pages are programmed
+  Persistent<Settings> settings(ep, 0x3E);
+  x = settings;
+  x.a = 7;
+  x.pad[39] = 9;
+  settings = x;
+  programs = sim.page_programs;
+  settings.commit();
+  assert(sim.page_programs - programs == 3 && settings.getPagePrograms() == 3);
+  x.pad[30] = 1;
+  settings = x;
+  programs = sim.page_programs;
+  settings.commit();
+  assert(sim.page_programs - programs == 1);
+  Persistent<Settings> loaded(ep, 0x3E);
+  assert(loaded.get().a == 7 && loaded.get().pad[39] == 9 && loaded.get().pad[30] == 1);
+
+  Persistent<Settings> bad(ep, 8190);
+  bad.get();
+  assert(bad.getError() == EEPROM_OutOfRange);
+
+  printf("ok\n");
+  return (0);
+}
@@ -0,0 +1,62 @@
+// PersistentCounter : values across mounts, mount after a torn slot write
+#include "mbed.h"
+#include "eeprom.h"
+#include "persistent_counter.h"
+#include <assert.h>
+
+static uint64_t remount(EEPROM &ep, uint32_t slots, PersistentCounter::CounterWidth width)
+{
+  PersistentCounter c(ep, 1024, slots, width);
+
+  c.mount();
+  assert(c.getError() == EEPROM_NoError);
+  return (c.getValue());
+}
+
+int main()
+{
+  PersistentCounter::CounterWidth widths[] = {PersistentCounter::Counter32, PersistentCounter::Counter64};
+  uint32_t sizes[] = {2, 3, 7, 16, 33};
+  uint32_t i, s, w, k;
+
+  sim.setup(8192, 2, 0, 32);
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+
+  for (w = 0; w < 2; w++)
+  {
+    for (s = 0; s < 5; s++)
+    {
+      sim.setup(8192, 2, 0, 32);
+      assert(remount(ep, sizes[s], widths[w]) == 0);
+
+      // Every value is found by a new mount, over several passes of the ring
+      for (i = 1; i < 3 * sizes[s] + 5; i++)
+      {
+        PersistentCounter c(ep, 1024, sizes[s], widths[w]);
+        c.increment();
+        assert(remount(ep, sizes[s], widths[w]) == i);
+      }
+
+      // Power lost during each byte of the next slot write : the previous value is kept
+      for (k = 0; k < 4; k++)
+      {
+        PersistentCounter c(ep, 1024, sizes[s], widths[w]);
+        sim.tear(0, k);
+        c.increment();
+        sim.powerOn();
+        assert(remount(ep, sizes[s], widths[w]) == i - 1);
+      }
+
+      // The ring goes on after the torn slot
+      {
+        PersistentCounter c(ep, 1024, sizes[s], widths[w]);
+        c.increment();
+        c.increment();
+        assert(remount(ep, sizes[s], widths[w]) == i + 1);
+      }
+    }
+  }
+
+  printf("ok\n");
+  return (0);
+}
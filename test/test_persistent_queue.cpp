@@ -0,0 +1,107 @@
+// PersistentQueue : order across mounts, wrap, records larger than a page, mount after a torn push
+#include "mbed.h"
+#include "eeprom.h"
+#include "persistent_queue.h"
+#include <assert.h>
+
+static uint32_t remount(EEPROM &ep)
+{
+  PersistentQueue q(ep, 0x100, 0x400, 20, 8);
+
+  q.mount();
+  assert(q.getError() == EEPROM_NoError);
+  return (q.getCount());
+}
+
+int main()
+{
+  static int8_t big[70], out[70];
+  char m[64], e[16];
+  uint16_t n;
+  long programs;
+  int i, k;
+
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 1;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+
+  // 32 bytes slots from 0x180, metadata ring of 8 slots
+  {
+    PersistentQueue q(ep, 0x100, 0x400, 20, 8);
+    q.mount();
+    assert(q.getError() == EEPROM_NoError && q.getCapacity() == 28 && q.getCount() == 0);
+    assert(!q.peek(m, n) && !q.pop());
+    for (i = 0; i < 28; i++)
+    {
+      sprintf(m, "msg %d", i);
+      assert(q.push(m, strlen(m) + 1));
+    }
+    assert(!q.push("x", 2) && q.getError() == EEPROM_NoError);
+
+    // A pop is one metadata program
+    programs = sim.page_programs;
+    for (i = 0; i < 5; i++)
+    {
+      sprintf(e, "msg %d", i);
+      assert(q.peek(m, n) && !strcmp(m, e) && n == strlen(e) + 1);
+      assert(q.pop());
+    }
+    assert(sim.page_programs - programs == 5);
+  }
+
+  // The order is kept by a new mount and after the records wrap
+  {
+    PersistentQueue q(ep, 0x100, 0x400, 20, 8);
+    q.mount();
+    assert(q.getCount() == 23);
+    for (i = 0; i < 5; i++)
+      assert(q.push("wrap", 5));
+    for (k = 5; q.peek(m, n); k++)
+    {
+      sprintf(e, "msg %d", k);
+      assert(!strcmp(m, k < 28 ? e : "wrap"));
+      q.pop();
+    }
+    assert(k == 33);
+  }
+
+  // Power lost during the record program or before the CRC of the metadata : the push is lost, the queue is kept
+  for (i = 0; i < 3; i++)
+  {
+    PersistentQueue q(ep, 0x100, 0x400, 20, 8);
+    q.push("keep", 5);
+  }
+  for (k = 0; k < 2 * 11; k++)
+  {
+    PersistentQueue q(ep, 0x100, 0x400, 20, 8);
+    q.mount();
+    sim.tear(k / 11, k % 11);
+    q.push("torn", 5);
+    sim.powerOn();
+    assert(remount(ep) == 3);
+  }
+  {
+    PersistentQueue q(ep, 0x100, 0x400, 20, 8);
+    assert(q.push("next", 5) && remount(ep) == 4);
+    for (i = 0; i < 3; i++)
+    {
+      assert(q.peek(m, n) && !strcmp(m, "keep"));
+      q.pop();
+    }
+    assert(q.peek(m, n) && !strcmp(m, "next"));
+  }
+
+  // Records larger than a page, 96 bytes slots
+  {
+    PersistentQueue q(ep, 0x800, 0x400, 70, 4);
+    for (i = 0; i < 70; i++)
+      big[i] = i;
+    q.mount();
+    assert(q.getCapacity() == (0x400 - 64) / 96);
+    assert(q.push(big, 70) && q.peek(out, n) && n == 70 && !memcmp(big, out, 70));
+    assert(!q.push(big, 71) && q.getError() == EEPROM_ParamError);
+  }
+
+  printf("ok\n");
+  return (0);
+}
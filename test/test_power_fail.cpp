@@ -0,0 +1,82 @@
+// Power fail flush : pages kept within the hold-up time, gaps read back, bus budget bypassed and left as set
+#include "mbed.h"
+#include "eeprom.h"
+#include "eeprom_scheduler.h"
+#include <assert.h>
+
+int main()
+{
+  static int8_t a[20], b[20], c[8], d[32], e[10], f[4], g[4];
+  PowerFailReport report;
+  uint32_t dropped, start;
+  long programs;
+  int i;
+
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 2;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+  assert(ep.getTransferTime(32) == 788 && ep.getProgramTime(32) == 5788);
+  EEPROMScheduler scheduler(ep);
+  memset(a, 1, 20);
+  memset(b, 2, 20);
+  memset(c, 3, 8);
+  memset(d, 4, 32);
+  memset(e, 5, 10);
+  memset(f, 6, 4);
+  memset(g, 7, 4);
+
+  // Three pages fit in the hold-up time, the background write is dropped
+  scheduler.write(0, a, 20);
+  scheduler.write(10, b, 20);
+  dropped = scheduler.write(96, c, 8, EEPROMScheduler::Background);
+  scheduler.write(160, d, 32, EEPROMScheduler::Critical);
+  scheduler.write(40, e, 10);
+  scheduler.setHoldUpTime(3 * 5788);
+  programs = sim.page_programs;
+  scheduler.powerFail(report);
+  assert(sim.page_programs - programs == 3);
+  assert(report.pages_programmed == 3 && report.pages_dropped == 1 && report.bytes_dropped == 8);
+  assert(report.dropped_count == 1 && report.dropped[0] == dropped && scheduler.getPending() == 0);
+  for (i = 0; i < 10; i++)
+    assert(sim.mem[i] == 1);
+  for (i = 10; i < 30; i++)
+    assert(sim.mem[i] == 2);
+  for (i = 40; i < 50; i++)
+    assert(sim.mem[i] == 5);
+  for (i = 160; i < 192; i++)
+    assert(sim.mem[i] == 4);
+  assert(sim.mem[30] == 0xFF && sim.mem[96] == 0xFF);
+
+  // A gap inside a page is read back, its transfer time is planned
+  scheduler.write(200, f, 4);
+  scheduler.write(220, g, 4);
+  scheduler.setHoldUpTime(5608 + 608);
+  scheduler.powerFail(report);
+  assert(report.pages_programmed == 1 && sim.mem[200] == 6 && sim.mem[223] == 7 && sim.mem[210] == 0xFF);
+
+  // The bus budget does not delay the flush, it applies again after it
+  ep.setBusBudget(100, 40);
+  scheduler.write(300, d, 32);
+  scheduler.write(340, d, 32);
+  scheduler.setHoldUpTime(10 * 5788);
+  start = sim_us;
+  scheduler.powerFail(report);
+  assert(!report.budget_suspended && report.pages_programmed == 3 && sim_us == start);
+  ep.write(400, d, 32);
+  assert(sim_us > start);
+
+  // A budget suspended by the application stays suspended after a power fail or a flush
+  assert(!ep.suspendBusBudget(true));
+  scheduler.write(300, e, 10);
+  scheduler.powerFail(report);
+  assert(report.budget_suspended && report.pages_programmed == 1);
+  scheduler.write(340, e, 10);
+  scheduler.flush();
+  start = sim_us;
+  for (i = 0; i < 10; i++)
+    ep.write(400, d, 32);
+  assert(sim_us == start && ep.suspendBusBudget(false));
+
+  printf("ok\n");
+  return (0);
+}
@@ -0,0 +1,55 @@
+// Read while write : reads of the bytes in write cycle are served without polling the chip
+#include "mbed.h"
+#include "eeprom.h"
+#include "eeprom_spi.h"
+#include <assert.h>
+
+int main()
+{
+  static int8_t data[1024], back[1024];
+  int32_t value = 1234, read_value = 0;
+  long probes, reads;
+  int i;
+
+  for (i = 0; i < 1024; i++)
+    data[i] = i * 13 + 1;
+
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 50;
+  {
+    EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+    ep.setReadWhileWrite(true);
+
+    // Served from the pending page : no poll, no bus read
+    ep.write(100, value);
+    probes = sim.probes;
+    reads = sim.reads;
+    ep.read(100, read_value);
+    assert(read_value == 1234 && sim.probes == probes && sim.reads == reads);
+
+    // Another address waits for the end of the write cycle
+    ep.read(200, back, 4);
+    assert(sim.probes > probes && ep.getError() == EEPROM_NoError);
+
+    ep.write(10, data, 1000);
+    ep.read(10, back, 1000);
+    assert(!memcmp(data, back, 1000));
+  }
+
+  sim.setup(32768, 2, 0, 64);
+  sim.busy_cycles = 50;
+  {
+    EEPROMSPI ep(p5, p6, p7, p8, EEPROM::T25LC256);
+    ep.setReadWhileWrite(true);
+
+    // The last page is pending, the others are read from the chip
+    ep.write(64, data, 300);
+    ep.read(64 + 256, back, 44);
+    assert(!memcmp(back, data + 256, 44));
+    ep.read(64, back, 300);
+    assert(!memcmp(back, data, 300) && ep.getError() == EEPROM_NoError);
+  }
+
+  printf("ok\n");
+  return (0);
+}
@@ -0,0 +1,119 @@
+// RingLog : records across mounts, seek, mount after torn appends (oldest slot, slot 0, data)
+#include "mbed.h"
+#include "eeprom.h"
+#include "ring_log.h"
+#include <assert.h>
+
+static int8_t d[20], o[20];
+
+static uint32_t remount(RingLog &r)
+{
+  r.mount();
+  assert(r.getError() == EEPROM_NoError);
+  return (r.getCount());
+}
+
+int main()
+{
+  static int8_t big[40], out[40];
+  uint32_t ts;
+  int i, k;
+
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 0;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+
+  // 32 bytes slots, 16 slots
+  {
+    RingLog r(ep, 0x100, 0x200, 20);
+    assert(remount(r) == 0 && r.getCapacity() == 16);
+    for (i = 0; i < 10; i++)
+    {
+      memset(d, i, 20);
+      r.append(i * 10, d);
+    }
+  }
+  {
+    RingLog r(ep, 0x100, 0x200, 20);
+    assert(remount(r) == 10);
+    assert(r.seek(0) == 0 && r.seek(35) == 4 && r.seek(40) == 4 && r.seek(1000) == 10);
+    for (i = 10; i < 37; i++)
+    {
+      memset(d, i, 20);
+      r.append(i * 10, d);
+    }
+    assert(r.getCount() == 16 && r.read(0, ts, o) && ts == 210 && o[0] == 21);
+  }
+
+  // Second pass : slot 4 is the newest one, slot 5 the oldest one
+  {
+    RingLog r(ep, 0x100, 0x200, 20);
+    assert(remount(r) == 16);
+    assert(r.read(0, ts, o) && ts == 210 && o[5] == 21 && r.read(15, ts, o) && ts == 360);
+    assert(r.seek(255) == 5 && r.seek(0) == 0 && r.seek(361) == 16);
+  }
+
+  // Power lost during the header of the next append : the oldest record is lost, the others are kept
+  for (k = 1; k < 10; k++)
+  {
+    RingLog r(ep, 0x100, 0x200, 20);
+    r.mount();
+    memset(d, 99, 20);
+    sim.tear(0, k);
+    r.append(370, d);
+    sim.powerOn();
+    assert(remount(r) == 15);
+    assert(r.read(0, ts, o) && ts == 220 && r.read(14, ts, o) && ts == 360);
+  }
+  {
+    RingLog r(ep, 0x100, 0x200, 20);
+    r.mount();
+    r.append(370, d);
+    assert(remount(r) == 16);
+    assert(r.read(0, ts, o) && ts == 220 && r.read(15, ts, o) && ts == 370);
+  }
+
+  // Slot 0 torn while starting a new pass : the last slot is the newest one
+  {
+    RingLog r(ep, 0x100, 0x200, 20);
+    r.mount();
+    for (i = 0; i < 10; i++)
+    {
+      memset(d, 50 + i, 20);
+      r.append(400 + i, d);
+    }
+    sim.tear(0, 5);
+    r.append(410, d);
+    sim.powerOn();
+    assert(remount(r) == 15);
+    assert(r.read(14, ts, o) && ts == 409 && r.read(0, ts, o) && ts == 330);
+  }
+
+  // Power lost during the data of an append : the record is found, its data is rejected
+  {
+    RingLog r(ep, 0x100, 0x200, 20);
+    r.mount();
+    memset(d, 77, 20);
+    sim.tear(0, 20);
+    r.append(410, d);
+    sim.powerOn();
+    assert(remount(r) == 16);
+    assert(!r.read(15, ts, o) && r.getError() == EEPROM_NoError);
+    assert(r.read(14, ts, o) && ts == 409);
+  }
+
+  // Records larger than a page, 64 bytes slots
+  {
+    RingLog r(ep, 0x400, 0x400, 40);
+    for (i = 0; i < 40; i++)
+      big[i] = i;
+    r.mount();
+    r.append(5, big);
+    r.append(6, big);
+    RingLog r2(ep, 0x400, 0x400, 40);
+    assert(remount(r2) == 2 && r2.read(1, ts, out) && ts == 6 && !memcmp(big, out, 40));
+  }
+
+  printf("ok\n");
+  return (0);
+}
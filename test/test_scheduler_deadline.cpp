@@ -0,0 +1,47 @@
+// Scheduler priorities : background guard time, deadline ordering and misses
+#include "mbed.h"
+#include "eeprom.h"
+#include "eeprom_scheduler.h"
+#include <assert.h>
+
+int main()
+{
+  static int8_t data[64];
+  uint32_t background, plain, urgent, late;
+  int i;
+
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 0;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+  EEPROMScheduler scheduler(ep);
+  memset(data, 7, sizeof(data));
+
+  // Background work waits for the guard time without foreground traffic
+  scheduler.setBackgroundGuard(1000);
+  background = scheduler.write(0, data, 64, EEPROMScheduler::Background);
+  for (i = 0; i < 10; i++)
+    scheduler.process();
+  assert(!scheduler.isDone(background));
+  sim_us += 2000;
+  while (scheduler.process())
+    ;
+  assert(scheduler.isDone(background));
+
+  // The request with a deadline runs first
+  plain = scheduler.write(100, data, 10);
+  urgent = scheduler.write(200, data, 10, EEPROMScheduler::Normal, 50);
+  scheduler.process();
+  assert(scheduler.isDone(urgent) && !scheduler.isDone(plain));
+  sim_us += 100;
+  scheduler.flush();
+  assert(scheduler.getDeadlineMisses(EEPROMScheduler::Normal) == 0);
+
+  // A request done after its deadline is counted
+  late = scheduler.write(300, data, 10, EEPROMScheduler::Normal, 50);
+  sim_us += 100;
+  scheduler.flush();
+  assert(scheduler.isDone(late) && scheduler.getDeadlineMisses(EEPROMScheduler::Normal) == 1);
+
+  printf("ok\n");
+  return (0);
+}
@@ -0,0 +1,94 @@
+// Preemptible long writes : random mix of queued writes, critical reads run between
+// page programs and queued reads, checked against a RAM model of the chip
+#include "mbed.h"
+#include "eeprom.h"
+#include "eeprom_scheduler.h"
+#include <assert.h>
+
+#define BUFFERS 64
+
+int main()
+{
+  static int8_t writes[BUFFERS][200];
+  static int8_t reads[BUFFERS][200];
+  static uint8_t expected[BUFFERS][200];
+  static uint8_t model[8192];
+  uint32_t tickets[BUFFERS], sizes[BUFFERS];
+  uint32_t address, size, i;
+  int8_t back[200];
+  int it, k, op, written = 0, queued = 0;
+
+  sim.setup(8192, 2, 0, 32);
+  sim.busy_cycles = 5;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C64);
+  EEPROMScheduler scheduler(ep);
+  memset(model, 0xFF, sizeof(model));
+  srand(1);
+
+  for (it = 0; it < 3000; it++)
+  {
+    op = rand() % 4;
+    address = rand() % 8000;
+    size = 1 + rand() % 190;
+
+    if (op == 0)
+    {
+      // The write buffers are reused once the queue is flushed
+      if (++written % BUFFERS == 0)
+        scheduler.flush();
+      for (i = 0; i < size; i++)
+        writes[written % BUFFERS][i] = rand();
+      scheduler.write(address, writes[written % BUFFERS], size, (EEPROMScheduler::Priority)(rand() % 3), rand() % 3 ? 0 : rand() % 5000);
+      scheduler.setBackgroundGuard(rand() % 100);
+      memcpy(model + address, writes[written % BUFFERS], size);
+    }
+    else if (op == 1)
+    {
+      // Critical read : served at once, queued writes included
+      scheduler.read(address, back, size, EEPROMScheduler::Critical, rand() % 2 ? 100 : 0);
+      sim_us += 37;
+      assert(!memcmp(back, model + address, size));
+    }
+    else if (op == 2 && queued < BUFFERS)
+    {
+      tickets[queued] = scheduler.read(address, reads[queued], size, EEPROMScheduler::Normal);
+      sizes[queued] = size;
+      memcpy(expected[queued], model + address, size);
+      queued++;
+    }
+    else
+    {
+      scheduler.process();
+      scheduler.process();
+    }
+
+    // Queued reads see the data written before them
+    if (queued == BUFFERS || it % 500 == 0)
+    {
+      scheduler.flush();
+      for (k = 0; k < queued; k++)
+        assert(scheduler.isDone(tickets[k]) && !memcmp(reads[k], expected[k], sizes[k]));
+      queued = 0;
+    }
+    assert(scheduler.getError() == EEPROM_NoError);
+  }
+
+  scheduler.flush();
+  assert(!memcmp(&sim.mem[0], model, sizeof(model)));
+
+  // The read during write cycle mode of the eeprom is restored when the scheduler goes
+  {
+    EEPROM other(p9, p10, 0, EEPROM::T24C64);
+    {
+      EEPROMScheduler temporary(other);
+      other.write(0, back, 10);
+      assert(!other.isReady());
+    }
+    assert(other.isReady());
+    other.write(0, back, 10);
+    assert(other.isReady() && other.getError() == EEPROM_NoError);
+  }
+
+  printf("ok\n");
+  return (0);
+}
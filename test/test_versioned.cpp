@@ -0,0 +1,154 @@
+// Versioned : migration on load, commit programs, unknown versions, torn migrating commit
+#include "mbed.h"
+#include "eeprom.h"
+#include "versioned.h"
+#include <assert.h>
+
+struct V1
+{
+  int16_t setpoint;
+};
+
+struct V2
+{
+  int32_t setpoint;
+  int16_t gain;
+};
+
+struct V3
+{
+  int32_t setpoint;
+  int16_t gain;
+  int16_t pad;
+  int32_t extra;
+};
+
+static void migrate1(void *data, uint16_t &size)
+{
+  V1 from;
+  V2 to;
+
+  memcpy(&from, data, sizeof(from));
+  to.setpoint = from.setpoint;
+  to.gain = 10;
+  memcpy(data, &to, sizeof(to));
+  size = sizeof(to);
+}
+
+static void migrate2(void *data, uint16_t &size)
+{
+  V2 from;
+  V3 to;
+
+  memcpy(&from, data, sizeof(from));
+  memset(&to, 0, sizeof(to));
+  to.setpoint = from.setpoint;
+  to.gain = from.gain;
+  to.extra = 99;
+  memcpy(data, &to, sizeof(to));
+  size = sizeof(to);
+}
+
+int main()
+{
+  // Version 1 record : version, size, setpoint -5, blank up to the size of a version 3 record
+  static int8_t record1[VERSIONED_HeaderSize + sizeof(V3)] = {1, 0, 2, 0, -5, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1};
+  V1 initial1 = {0}, y;
+  V3 initial3, x;
+  long programs;
+  uint32_t k;
+
+  sim.setup(65536, 2, 0, 128);
+  sim.busy_cycles = 0;
+  EEPROM ep(p9, p10, 0, EEPROM::T24C512);
+  memset(&initial3, 0, sizeof(initial3));
+
+  {
+    Versioned<V1, 1> record(ep, 0x100, initial1);
+    assert(record.getStoredVersion() == VERSIONED_None);
+    y.setpoint = -5;
+    record = y;
+    record.commit();
+  }
+
+  // Migrated on load without any program, the migrating commit invalidates the header first
+  programs = sim.page_programs;
+  {
+    Versioned<V3, 3> record(ep, 0x100, initial3);
+    record.setMigration(1, migrate1);
+    record.setMigration(2, migrate2);
+    x = record;
+    assert(x.setpoint == -5 && x.gain == 10 && x.extra == 99 && record.getStoredVersion() == 1);
+    assert(sim.page_programs == programs && !record.isDirty());
+    record.commit();
+    assert(sim.page_programs == programs);
+    x.gain = 11;
+    record = x;
+    record.commit();
+    assert(sim.page_programs == programs + 3);
+    x.gain = 12;
+    record = x;
+    record.commit();
+    x.gain = 11;
+    record = x;
+    record.commit();
+    assert(sim.page_programs == programs + 5);
+  }
+  {
+    Versioned<V3, 3> record(ep, 0x100, initial3);
+    x = record;
+    assert(record.getStoredVersion() == 3 && x.gain == 11 && x.extra == 99);
+  }
+
+  // Newer version or missing migration : initial value
+  {
+    Versioned<V1, 1> record(ep, 0x100, initial1);
+    y = record;
+    assert(record.getStoredVersion() == VERSIONED_None && y.setpoint == 0);
+  }
+  {
+    ep.write(0x400, (int32_t)(1 | (2 << 16)));
+    Versioned<V3, 3> record(ep, 0x400, initial3);
+    record.setMigration(2, migrate2);
+    x = record;
+    assert(record.getStoredVersion() == VERSIONED_None && x.extra == 0);
+  }
+
+  // Power lost during each byte of the invalidation, value and header programs of a
+  // migrating commit : the old record, the initial value or the new record is loaded
+  for (k = 0; k < 2 + sizeof(V3) + VERSIONED_HeaderSize; k++)
+  {
+    ep.write(0x800, record1, sizeof(record1));
+    {
+      Versioned<V3, 3> record(ep, 0x800, initial3);
+      record.setMigration(1, migrate1);
+      record.setMigration(2, migrate2);
+      x = record;
+      x.gain = 11;
+      record = x;
+      if (k < 2)
+        sim.tear(0, k);
+      else if (k < 2 + sizeof(V3))
+        sim.tear(1, k - 2);
+      else
+        sim.tear(2, k - 2 - sizeof(V3));
+      record.commit();
+      sim.powerOn();
+    }
+
+    Versioned<V3, 3> record(ep, 0x800, initial3);
+    record.setMigration(1, migrate1);
+    record.setMigration(2, migrate2);
+    x = record;
+    assert(record.getError() == EEPROM_NoError);
+    if (k == 0)
+      assert(record.getStoredVersion() == 1 && x.setpoint == -5 && x.gain == 10);
+    else if (k < 2 + sizeof(V3) + VERSIONED_HeaderSize - 1)
+      assert(record.getStoredVersion() == VERSIONED_None && !memcmp(&x, &initial3, sizeof(V3)));
+    else
+      assert(record.getStoredVersion() == 3 && x.setpoint == -5 && x.gain == 11 && x.extra == 99);
+  }
+
+  printf("ok\n");
+  return (0);
+}
@@ -0,0 +1,446 @@
+#ifndef __VERSIONED__H_
+#define __VERSIONED__H_
+
+/***********************************************************
+Schema versioned record with lazy migration.
+
+Versioned<T, VERSION> stores a plain data struct behind a small header
+holding its schema version and size. The struct is read on the first
+access : a record of an older version is upgraded in RAM by the
+migration functions registered for each older version, one version
+step at a time. Nothing is written at that time, the record is written
+back (new header and value) only when it is modified and committed, so
+a firmware update costs no migration pass at boot.
+
+Like Persistent<T>, reads are served from RAM and commit() writes the
+changed bytes only, one page program per page holding changed bytes.
+The header is written after the value : a commit that changes the
+version first invalidates the header, so a record torn during the
+commit is loaded with the initial value, never as a mix of versions.
+A blank record or a record of an unknown version (newer firmware, no
+migration registered) is loaded with the initial value.
+
+Record layout (little endian) :
+  - schema version (uint16_t)
+  - struct size in bytes (uint16_t)
+  - struct
+************************************************************/
+
+// Includes
+#include "eeprom.h"
+#include "persistent.h"
+
+// Example
+/*
+#include "mbed.h"
+#include "eeprom.h"
+#include "versioned.h"
+
+struct SettingsV1 { int16_t setpoint; };
+struct Settings { int32_t setpoint; float gain; };    // Version 2
+
+void settingsV1(void *data, uint16_t &size)           // Version 1 to 2
+{
+  SettingsV1 old;
+  Settings *s = (Settings *)data;
+
+  memcpy(&old,data,sizeof(old));
+  s->setpoint = old.setpoint;
+  s->gain = 1.0;
+  size = sizeof(Settings);
+}
+
+EEPROM ep(p9,p10,0,EEPROM::T24C512);
+Settings defaults = {0, 1.0};
+Versioned<Settings, 2> settings(ep,0x100,defaults);
+
+int main()
+{
+  Settings s;
+
+  settings.setMigration(1,settingsV1);
+  s = settings;                   // Upgraded in RAM, nothing written
+  s.gain = 2.0;
+  settings = s;
+  settings.commit();              // Version 2 written
+
+  return(0);
+}
+*/
+
+// Defines
+#define VERSIONED_HeaderSize 4
+#define VERSIONED_None 0xFFFF
+
+/** Migration of a record from a version to the next one, in place
+ * @param data record, buffer of MAXSIZE bytes (void *)
+ * @param size record size in bytes, to update (uint16_t&)
+ */
+typedef void (*VersionMigration)(void *data, uint16_t &size);
+
+/** Versioned Class
+ */
+template <class T, uint16_t VERSION, uint16_t MAXSIZE = sizeof(T)>
+class Versioned
+{
+public:
+  /**
+   * Constructor, no access is done to the eeprom (see get)
+   * @param ep eeprom holding the record (EEPROM&)
+   * @param address record address (uint32_t)
+   * @param initial value of a blank or unknown record (const T&)
+   * @return none
+   */
+  Versioned(EEPROM &ep, uint32_t address, const T &initial);
+
+  /**
+   * Register the migration of the records of a version to the next version
+   * @param from version to upgrade, lower than VERSION (uint16_t)
+   * @param migration migration function (VersionMigration)
+   * @return none
+   */
+  void setMigration(uint16_t from, VersionMigration migration);
+
+  /**
+   * Get the value, read and upgraded on the first access
+   * @param none
+   * @return value (const T&)
+   */
+  const T &get(void);
+
+  /**
+   * Get the value, read and upgraded on the first access
+   * @param none
+   * @return value (const T&)
+   */
+  operator const T &(void);
+
+  /**
+   * Set the value, the eeprom is written by commit
+   * @param value new value (const T&)
+   * @return none
+   */
+  void set(const T &value);
+
+  /**
+   * Set the value, the eeprom is written by commit
+   * @param value new value (const T&)
+   * @return this record (Versioned&)
+   */
+  Versioned &operator=(const T &value);
+
+  /**
+   * Check if the value has been changed since the last commit
+   * @param none
+   * @return true if changed, overwise false (bool)
+   */
+  bool isDirty(void);
+
+  /**
+   * Write the record if it has been changed, current version header included
+   * @param none
+   * @return none
+   */
+  void commit(void);
+
+  /**
+   * Get the version of the record found in the eeprom
+   * @param none
+   * @return version, VERSIONED_None if blank or unknown (uint16_t)
+   */
+  uint16_t getStoredVersion(void);
+
+  /**
+   * Get the current error number (EEPROM_NoError if no error)
+   * @param  none
+   * @return none
+   */
+  uint8_t getError(void);
+
+  //---------- local variables ----------
+private:
+  static_assert(MAXSIZE >= sizeof(T), "MAXSIZE lower than the record size");
+
+  EEPROM &_ep;                                      // EEPROM holding the record
+  uint32_t _address;                                // Record address
+  uint8_t _errnum;                                  // Error number
+  bool _loaded;                                     // Value read from the eeprom
+  bool _dirty;                                      // Value changed since the last commit
+  uint16_t _version;                                // Version found in the eeprom
+  union
+  {
+    T _value;                                       // RAM value
+    uint8_t _work[MAXSIZE];                         // Migration buffer, the value once upgraded
+  };
+  T _initial;                                       // Value of a blank or unknown record
+  uint8_t _stored[VERSIONED_HeaderSize + sizeof(T)]; // Eeprom copy, raw
+  VersionMigration _migrations[VERSION + 1];        // Migrations, by version
+  void load(void);                                  // Read and upgrade the record
+  //-------------------------------------
+};
+
+/**
+ * Versioned(EEPROM &ep, uint32_t address, const T &initial)
+ *
+ * Constructor, no access is done to the eeprom (see get)
+ * @param ep eeprom holding the record (EEPROM&)
+ * @param address record address (uint32_t)
+ * @param initial value of a blank or unknown record (const T&)
+ * @return none
+ */
+template <class T, uint16_t VERSION, uint16_t MAXSIZE>
+Versioned<T, VERSION, MAXSIZE>::Versioned(EEPROM &ep, uint32_t address, const T &initial) : _ep(ep)
+{
+  _address = address;
+  _errnum = EEPROM_NoError;
+  _loaded = false;
+  _dirty = false;
+  _version = VERSIONED_None;
+  memcpy(&_initial, &initial, sizeof(T));
+  memset(_migrations, 0, sizeof(_migrations));
+
+  if (address + VERSIONED_HeaderSize + MAXSIZE > ep.getSize())
+    _errnum = EEPROM_OutOfRange;
+}
+
+/**
+ * void setMigration(uint16_t from, VersionMigration migration)
+ *
+ * Register the migration of the records of a version to the next version
+ * @param from version to upgrade, lower than VERSION (uint16_t)
+ * @param migration migration function (VersionMigration)
+ * @return none
+ */
+template <class T, uint16_t VERSION, uint16_t MAXSIZE>
+void Versioned<T, VERSION, MAXSIZE>::setMigration(uint16_t from, VersionMigration migration)
+{
+  if (from >= VERSION)
+  {
+    _errnum = EEPROM_ParamError;
+    return;
+  }
+
+  _migrations[from] = migration;
+}
+
+/**
+ * const T &get(void)
+ *
+ * Get the value, read and upgraded on the first access
+ * @param none
+ * @return value (const T&)
+ */
+template <class T, uint16_t VERSION, uint16_t MAXSIZE>
+const T &Versioned<T, VERSION, MAXSIZE>::get(void)
+{
+  if (!_loaded)
+    load();
+
+  return (_value);
+}
+
+/**
+ * operator const T &(void)
+ *
+ * Get the value, read and upgraded on the first access
+ * @param none
+ * @return value (const T&)
+ */
+template <class T, uint16_t VERSION, uint16_t MAXSIZE>
+Versioned<T, VERSION, MAXSIZE>::operator const T &(void)
+{
+  return (get());
+}
+
+/**
+ * void set(const T &value)
+ *
+ * Set the value, the eeprom is written by commit
+ * @param value new value (const T&)
+ * @return none
+ */
+template <class T, uint16_t VERSION, uint16_t MAXSIZE>
+void Versioned<T, VERSION, MAXSIZE>::set(const T &value)
+{
+  if (!_loaded)
+    load();
+
+  if (memcmp(&_value, &value, sizeof(T)))
+  {
+    memcpy(&_value, &value, sizeof(T));
+    _dirty = true;
+  }
+}
+
+/**
+ * Versioned &operator=(const T &value)
+ *
+ * Set the value, the eeprom is written by commit
+ * @param value new value (const T&)
+ * @return this record (Versioned&)
+ */
+template <class T, uint16_t VERSION, uint16_t MAXSIZE>
+Versioned<T, VERSION, MAXSIZE> &Versioned<T, VERSION, MAXSIZE>::operator=(const T &value)
+{
+  set(value);
+
+  return (*this);
+}
+
+/**
+ * bool isDirty(void)
+ *
+ * Check if the value has been changed since the last commit
+ * @param none
+ * @return true if changed, overwise false (bool)
+ */
+template <class T, uint16_t VERSION, uint16_t MAXSIZE>
+bool Versioned<T, VERSION, MAXSIZE>::isDirty(void)
+{
+  return (_dirty);
+}
+
+/**
+ * void commit(void)
+ *
+ * Write the record if it has been changed : the value then the current version
+ * header are compared with the raw eeprom copy, for each page one page program
+ * from the first to the last changed byte of the page. If the header changes, its
+ * version is first set to VERSIONED_None so that a torn commit is not loaded
+ * @param none
+ * @return none
+ */
+template <class T, uint16_t VERSION, uint16_t MAXSIZE>
+void Versioned<T, VERSION, MAXSIZE>::commit(void)
+{
+  uint8_t header[VERSIONED_HeaderSize];
+  uint16_t version = VERSION, size = sizeof(T);
+  uint16_t none = VERSIONED_None;
+
+  // Check error
+  if (_errnum || !_dirty)
+    return;
+
+  memcpy(header, &version, 2);
+  memcpy(header + 2, &size, 2);
+
+  // Header invalidated before the value is changed under it
+  if (memcmp(header, _stored, VERSIONED_HeaderSize))
+    persistentWrite(_ep, _address, (const uint8_t *)&none, _stored, 2);
+
+  // Value, then the header as the commit marker
+  if (_ep.getError() == EEPROM_NoError)
+    persistentWrite(_ep, _address + VERSIONED_HeaderSize, (const uint8_t *)&_value, _stored + VERSIONED_HeaderSize, sizeof(T));
+  if (_ep.getError() == EEPROM_NoError)
+    persistentWrite(_ep, _address, header, _stored, VERSIONED_HeaderSize);
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return;
+  }
+
+  _dirty = false;
+  _version = VERSION;
+}
+
+/**
+ * uint16_t getStoredVersion(void)
+ *
+ * Get the version of the record found in the eeprom
+ * @param none
+ * @return version, VERSIONED_None if blank or unknown (uint16_t)
+ */
+template <class T, uint16_t VERSION, uint16_t MAXSIZE>
+uint16_t Versioned<T, VERSION, MAXSIZE>::getStoredVersion(void)
+{
+  if (!_loaded)
+    load();
+
+  return (_version);
+}
+
+/**
+ * uint8_t getError(void)
+ *
+ * Get the current error number (EEPROM_NoError if no error)
+ * @param none
+ * @return none
+ */
+template <class T, uint16_t VERSION, uint16_t MAXSIZE>
+uint8_t Versioned<T, VERSION, MAXSIZE>::getError(void)
+{
+  return (_errnum);
+}
+
+/**
+ * void load(void)
+ *
+ * Read the record and upgrade it in RAM to the current version
+ * @param none
+ * @return none
+ */
+template <class T, uint16_t VERSION, uint16_t MAXSIZE>
+void Versioned<T, VERSION, MAXSIZE>::load(void)
+{
+  uint16_t version, size, v;
+
+  _loaded = true;
+  _version = VERSIONED_None;
+  memcpy(&_value, &_initial, sizeof(T));
+  memset(_stored, 0, sizeof(_stored));
+
+  // Check error
+  if (_errnum)
+    return;
+
+  _ep.read(_address, (int8_t *)_stored, sizeof(_stored));
+  if (_ep.getError() != EEPROM_NoError)
+  {
+    _errnum = _ep.getError();
+    return;
+  }
+
+  memcpy(&version, _stored, 2);
+  memcpy(&size, _stored + 2, 2);
+
+  // Current version
+  if (version == VERSION && size == sizeof(T))
+  {
+    memcpy(&_value, _stored + VERSIONED_HeaderSize, sizeof(T));
+    _version = version;
+    return;
+  }
+
+  // Blank, newer or unknown version, current version of another size (header torn
+  // between its version and its size) : initial value
+  if (version >= VERSION || size > MAXSIZE)
+    return;
+  for (v = version; v < VERSION; v++)
+  {
+    if (!_migrations[v])
+      return;
+  }
+
+  // Upgrade one version at a time, in place in the value buffer
+  memset(_work, 0, sizeof(_work));
+  if (size)
+    _ep.read(_address + VERSIONED_HeaderSize, (int8_t *)_work, size);
+  if (_ep.getError() != EEPROM_NoError)
+    _errnum = _ep.getError();
+  for (v = version; v < VERSION && !_errnum; v++)
+  {
+    _migrations[v](_work, size);
+    if (size > MAXSIZE)
+      _errnum = EEPROM_ParamError;
+  }
+  if (!_errnum && size != sizeof(T))
+    _errnum = EEPROM_ParamError;
+
+  if (_errnum)
+  {
+    memcpy(&_value, &_initial, sizeof(T));
+    return;
+  }
+  _version = version;
+}
+#endif